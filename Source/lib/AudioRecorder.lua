@@ -1,26 +1,49 @@
 -- AudioRecorder: Wrapper for the C mic extension
--- Provides μ-law compressed audio chunks for progressive upload
+-- Provides compressed audio chunks for progressive upload, queued on disk
 
 AudioRecorder = {}
 
+-- Backup WAV is streamed here while recording (overwritten each session)
+local BACKUP_DIR = "cache"
+local BACKUP_PATH = BACKUP_DIR .. "/recording.wav"
+-- Chunks waiting for upload are spooled here (deleted when the session ends)
+local SPOOL_PATH = BACKUP_DIR .. "/spool.bin"
+
 -- Recording state
 local currentRecording = nil
 local recordingStartTime = nil
-local chunks = {}  -- Array of compressed μ-law chunks for progressive upload
+
+-- Filled in place by poll() so a per-frame call allocates nothing
+local status = {
+    level = 0,          -- Smoothed RMS (0.0 - 1.0)
+    peak = 0,           -- Held peak (0.0 - 1.0)
+    speech = false,     -- VAD hears speech
+    duration = 0,       -- Seconds recorded
+    pendingChunks = 0,  -- Chunks produced but not yet uploaded
+    sequence = 0,       -- Highest chunk sequence spooled (produced without a spool)
+    encodedBytes = 0,   -- Compressed bytes in chunks so far
+    droppedBytes = 0,   -- Bytes the VAD saved by skipping silence
+}
 
 -- Start recording
-function AudioRecorder.start()
+-- With spool set, chunks are queued on disk for upload (see readSpooledChunk);
+-- without it they wait in the C ring for getChunk()
+function AudioRecorder.start(spool)
     if AudioRecorder.isRecording() then
         return false, "Already recording"
     end
 
     -- Clear previous data
-    chunks = {}
     currentRecording = nil
     recordingStartTime = playdate.getCurrentTimeMilliseconds()
 
-    -- Start the C extension
-    local success, err = mic.startRecording()
+    -- Ensure backup directory exists
+    if not playdate.file.isdir(BACKUP_DIR) then
+        playdate.file.mkdir(BACKUP_DIR)
+    end
+
+    -- Start the C extension (backup streams to disk in fixed blocks)
+    local success, err = mic.startRecording(BACKUP_PATH, spool and SPOOL_PATH or nil)
     if not success then
         return false, err or "Failed to start recording"
     end
@@ -28,14 +51,14 @@ function AudioRecorder.start()
     return true
 end
 
--- Stop recording and get WAV data (8kHz, 16-bit for local backup)
+-- Stop recording and get the backup WAV path (8kHz, 16-bit for local backup)
 function AudioRecorder.stop()
     if not AudioRecorder.isRecording() then
         return nil, "Not recording"
     end
 
-    -- Get any remaining audio from C extension (returns WAV for backup)
-    local wavData, err = mic.stopRecording()
+    -- Finish the backup file in the C extension (returns its path)
+    local wavPath, err = mic.stopRecording()
 
     -- Calculate total duration
     local duration = 0
@@ -45,21 +68,54 @@ function AudioRecorder.stop()
 
     recordingStartTime = nil
 
-    if wavData then
-        return wavData, duration
+    if wavPath then
+        return wavPath, duration
     else
         return nil, err or "No audio recorded"
     end
 end
 
+-- Service the recorder (writes pending backup audio and chunks to disk) - call every frame
+function AudioRecorder.update()
+    mic.update()
+end
+
+-- Service the recorder and read its state in a single call into C - use this
+-- instead of update() plus the separate getters when calling every frame
+-- Returns a status table that is reused between calls (copy fields to keep them)
+function AudioRecorder.poll()
+    status.level, status.peak, status.speech, status.duration, status.pendingChunks,
+        status.sequence, status.encodedBytes, status.droppedBytes = mic.poll()
+    return status
+end
+
+-- Capture pipeline counters for the current (or last) recording, for sizing
+-- chunk durations and codecs on a device (callback times are in microseconds;
+-- codec byte totals are since launch)
+function AudioRecorder.getStats()
+    local stats = {}
+    stats.callbacks, stats.callbackAvgUs, stats.callbackMinUs, stats.callbackMaxUs,
+        stats.chunksLost, stats.framesLost, stats.oomEvents, stats.backupDropped,
+        stats.framesKept, stats.framesDropped, stats.mulawBytes, stats.adpcmBytes = mic.getStats()
+    local frames = stats.framesKept + stats.framesDropped
+    stats.vadKeepRatio = frames > 0 and stats.framesKept / frames or 0
+    return stats
+end
+
 -- Check if currently recording
 function AudioRecorder.isRecording()
     return mic.isRecording()
 end
 
+-- Get the meter levels in one call: rms, peak (0.0 - 1.0, peak is held then
+-- decays) and whether the VAD currently hears speech
+function AudioRecorder.getLevels()
+    return mic.getLevels()
+end
+
 -- Get current mic level (0.0 - 1.0)
 function AudioRecorder.getLevel()
-    return mic.getLevel()
+    return (mic.getLevels())
 end
 
 -- Get current recording duration in seconds
@@ -67,30 +123,100 @@ function AudioRecorder.getDuration()
     return mic.getDuration()
 end
 
--- Check if a compressed chunk is ready (30 seconds)
+-- Check if a compressed chunk is pending (chunks queue up in the C ring buffer)
 function AudioRecorder.hasChunk()
     return mic.hasChunk()
 end
 
--- Get the ready chunk (returns μ-law compressed data, or nil if no chunk ready)
+-- Get the oldest pending chunk (returns μ-law compressed data and its sequence
+-- number, or nil if no chunk is pending)
 -- This data should be uploaded directly to the server
+-- Returns data, sequence number, frame map (run lengths of kept/dropped
+-- 20ms VAD frames, as uint16 LE; lets the server rebuild original timing)
+-- and the number of frames at the start repeated from the previous chunk
 function AudioRecorder.getChunk()
-    local compressedData = mic.getChunk()
+    local compressedData, chunkSeq, frameMap, overlapFrames = mic.getChunk()
     if compressedData then
-        table.insert(chunks, compressedData)
-        return compressedData
+        return compressedData, chunkSeq, frameMap, overlapFrames
     end
     return nil
 end
 
--- Get current chunk sequence number (for ordering on server)
+-- Get the highest chunk sequence number on the spool (chunks are numbered
+-- 1, 2, ... with no gaps) and how many are still waiting for an ack
+function AudioRecorder.getSpooledSequence()
+    return mic.getSpooledSequence()
+end
+
+-- Read a spooled chunk back for upload: returns the request body (frame map
+-- followed by audio), frame map bytes and overlap frames, or nil if the chunk
+-- is gone (already acked) or failed its CRC check
+function AudioRecorder.readSpooledChunk(seq)
+    return mic.spoolRead(seq)
+end
+
+-- Mark a spooled chunk as uploaded (spool is truncated once all are acked)
+function AudioRecorder.ackChunk(seq)
+    mic.spoolAck(seq)
+end
+
+-- Delete the spool (upload session finished or abandoned)
+function AudioRecorder.closeSpool()
+    mic.spoolClose()
+end
+
+-- Get sequence number of the last chunk retrieved (for ordering on server)
 function AudioRecorder.getChunkSequence()
     return mic.getChunkSequence()
 end
 
 -- Get number of completed chunks
 function AudioRecorder.getChunkCount()
-    return #chunks
+    local spooled = mic.getSpooledSequence()
+    return math.max(spooled, mic.getChunkSequence())
+end
+
+-- Select output sample rate (8000 or 16000 Hz); only takes effect before start()
+function AudioRecorder.setSampleRate(rate)
+    return mic.setSampleRate(rate)
+end
+
+-- Get output sample rate in Hz
+function AudioRecorder.getSampleRate()
+    return mic.getSampleRate()
+end
+
+-- Select upload codec ("mulaw" or "adpcm"); only takes effect before start()
+function AudioRecorder.setCodec(name)
+    return mic.setCodec(name)
+end
+
+-- Get selected upload codec name
+function AudioRecorder.getCodec()
+    return mic.getCodec()
+end
+
+-- Set chunk length (5-60 seconds) and optional overlap repeated at the start
+-- of each chunk (0-500 ms); only takes effect before start()
+-- Shorter chunks mean less audio left to upload when recording stops
+function AudioRecorder.setChunkDuration(seconds, overlapMs)
+    return mic.setChunkDuration(seconds, overlapMs)
+end
+
+-- Get chunk length in seconds and overlap in ms
+function AudioRecorder.getChunkDuration()
+    return mic.getChunkDuration()
+end
+
+-- Size the memory pool all recording buffers come from (256-8192 KB); only
+-- when not recording. Too small for the chunk settings and start() fails
+function AudioRecorder.setPoolSize(kb)
+    return mic.setPoolSize(kb)
+end
+
+-- Get the pool size and the part the current (or last) recording carved, in KB
+function AudioRecorder.getPoolSize()
+    return mic.getPoolSize()
 end
 
 -- Enable/disable Voice Activity Detection (VAD)
@@ -129,19 +255,17 @@ function AudioRecorder.loadFromFile(filename)
     return data
 end
 
--- Get compression stats for debugging
+-- Get compression stats for debugging (counted in C as chunks are produced)
 function AudioRecorder.getCompressionInfo()
-    local rawSamplesExpected = AudioRecorder.getDuration() * 8000  -- 8kHz
-    local rawBytes = rawSamplesExpected * 2  -- 16-bit
-    local compressedBytes = 0
-    for _, chunk in ipairs(chunks) do
-        compressedBytes = compressedBytes + #chunk
-    end
+    local poll = AudioRecorder.poll()
+    local rawBytes = poll.duration * AudioRecorder.getSampleRate() * 2  -- 16-bit
+    local compressedBytes = poll.encodedBytes
 
     return {
         rawBytes = rawBytes,
         compressedBytes = compressedBytes,
+        vadSavedBytes = poll.droppedBytes,
         ratio = rawBytes > 0 and (compressedBytes / rawBytes) or 0,
-        chunkCount = #chunks
+        chunkCount = poll.sequence
     }
 end
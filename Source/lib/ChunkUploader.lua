@@ -1,27 +1,78 @@
 -- ChunkUploader: Manages progressive upload of compressed audio chunks
 -- Uses polling-based HTTP (Playdate SDK 3.0.2 API)
+-- /finalize and /process run as server jobs: the POST returns a job id straight
+-- away and GET /job/<id> is polled for the result (429 means wait Retry-After)
+-- Chunks wait in AudioRecorder's on-disk spool; only the ones being uploaded
+-- are read into memory, and each is acked (and dropped from the spool) on 200
+-- Between recordings the control connection pushes note changes to the
+-- server (NotesStore.nextSync) one delta at a time, as a background backup
 
 ChunkUploader = {}
 
 -- Configuration
-local MAX_RETRIES = 3
-local TIMEOUT_MS = 30000  -- 30 second timeout
+local MAX_RETRIES = 3             -- Quick retries before backing off
+local RETRY_BACKOFF_MS = 15000    -- Wait before another round of retries
+local TIMEOUT_MS = 30000  -- 30 second timeout (uploads and job POSTs)
+local PARTIAL_POLL_MS = 4000     -- How often to ask for live transcript text
+local PARTIAL_TIMEOUT_MS = 10000 -- Give up on a poll sooner than an upload
+local DEFAULT_UPLOAD_SLOTS = 2   -- Uploads in flight at once (settings.uploadSlots)
+local MAX_UPLOAD_SLOTS = 4
+local JOB_POLL_MS = 1000         -- How often to poll a queued finalize/process job
+local JOB_DEADLINE_MS = 600000   -- Give up on a job (including 429 waits) after this
+local BUSY_RETRY_MS = 5000       -- Wait after a 429 that carries no Retry-After
+local JOB_WAIT_SECONDS = 2       -- Server holds a streaming job poll this long for new text
+local NOTE_SYNC_INTERVAL_MS = 1000      -- Gap between note deltas while catching up
+local NOTE_SYNC_IDLE_MS = 5000          -- How often to look for note changes when in step
+local NOTE_SYNC_BACKOFF_MS = 30000      -- First wait after a failed push (doubles each time)
+local NOTE_SYNC_MAX_BACKOFF_MS = 600000
+
+-- Content-Type sent with each chunk, by codec (server picks its decoder from this)
+local CODEC_CONTENT_TYPES = {
+    mulaw = "audio/mulaw",
+    adpcm = "audio/x-ima-adpcm",
+}
 
 -- State
-local uploadQueue = {}        -- Queue of chunks waiting to upload
+local uploadQueue = {}        -- Spooled chunks waiting to upload ({ seq, retries, retryAt })
 local sessionId = nil         -- Current session UUID
+local sampleRate = 8000       -- Sample rate of the session's audio (sent with each chunk)
+local contentType = CODEC_CONTENT_TYPES.mulaw  -- Codec of the session's audio
 local serverUrl = nil         -- Configured server URL
 local uploadedChunks = 0      -- Count of successfully uploaded chunks
-local failedChunks = 0        -- Count of failed uploads
+local failedChunks = 0        -- Chunks lost (unreadable from the spool)
 local totalBytesUploaded = 0  -- Total bytes sent
 local isEnabled = false       -- Whether uploader is active
-
--- HTTP state machine
-local httpConnection = nil    -- Current HTTP connection
-local httpState = "idle"      -- "idle" | "uploading" | "finalizing"
-local currentChunk = nil      -- Chunk being uploaded
+local deviceId = nil          -- Names this device's notes on the server (settings.deviceId)
+
+-- Live transcript (polled from /partial between uploads)
+local partialText = ""        -- Transcript text received so far
+local partialCursor = 0       -- Server cursor (chunks transcribed) for the next poll
+local lastPollTime = 0        -- When /partial was last requested
+local partialCallback = nil   -- Called with (newText, fullText) when text arrives
+
+-- Gap-only retransmit: after a failed upload, ask which chunks the server acked
+local needsStatusSync = false
+
+-- Upload slots: each keeps its own keep-alive connection open across chunks
+-- (so the TLS handshake is paid once per slot, not per chunk) and uploads one
+-- chunk at a time. Connections are only dropped after an error or timeout.
+local uploadSlots = {}        -- { connection, chunk, startTime } per slot
+local slotCount = DEFAULT_UPLOAD_SLOTS
+
+-- HTTP state machine for /partial and /finalize (separate from upload slots)
+local httpConnection = nil    -- Current control connection
+local httpState = "idle"      -- "idle" | "polling" | "syncing" | "finalizing" | "awaitingJob" | "jobPolling" | "noteSyncing"
 local requestStartTime = 0    -- For timeout tracking
 local finalizeCallback = nil  -- Callback for finalize completion
+local finalizeJobId = nil     -- Server job doing the finalize (nil until the POST is accepted)
+local jobWaitUntil = 0        -- Next job poll, or re-POST after a 429
+local jobDeadline = 0         -- When to give up on the finalize job
+
+-- Background note sync (only while no recording session is open)
+local noteDelta = nil         -- Delta being pushed
+local noteSyncAt = 0          -- Earliest time for the next push
+local noteSyncBackoff = NOTE_SYNC_BACKOFF_MS
+local noteAccessRequested = false
 
 -- Generate a simple UUID
 local function generateUUID()
@@ -33,27 +84,67 @@ local function generateUUID()
 end
 
 -- Initialize uploader with settings
+-- settings.uploadSlots sets how many chunks upload in parallel (1-4);
+-- settings.deviceId (if any) turns on the background note sync
 function ChunkUploader.init(settings)
     serverUrl = settings and settings.serverUrl
+    deviceId = settings and settings.deviceId
     isEnabled = serverUrl and serverUrl ~= ""
+    slotCount = math.max(1, math.min(settings and settings.uploadSlots or DEFAULT_UPLOAD_SLOTS,
+                                     MAX_UPLOAD_SLOTS))
     return isEnabled
 end
 
--- Start a new upload session
-function ChunkUploader.startSession()
+-- Close every upload slot's connection
+local function closeUploadSlots()
+    for _, slot in ipairs(uploadSlots) do
+        if slot.connection then
+            slot.connection:close()
+        end
+    end
+    uploadSlots = {}
+end
+
+-- Number of slots with an upload in flight
+local function busySlotCount()
+    local busy = 0
+    for _, slot in ipairs(uploadSlots) do
+        if slot.chunk then
+            busy = busy + 1
+        end
+    end
+    return busy
+end
+
+-- Start a new upload session (rate and codec of the chunks' audio,
+-- default 8000 Hz μ-law)
+function ChunkUploader.startSession(rate, codec)
     if not isEnabled then
         return nil, "Uploader not enabled (no server URL)"
     end
 
     sessionId = generateUUID()
+    sampleRate = rate or 8000
+    contentType = CODEC_CONTENT_TYPES[codec] or CODEC_CONTENT_TYPES.mulaw
     uploadQueue = {}
+    closeUploadSlots()
+    for i = 1, slotCount do
+        uploadSlots[i] = { connection = nil, chunk = nil, startTime = 0 }
+    end
+    if httpConnection then
+        httpConnection:close()  -- A note push; the delta goes again after the session
+    end
     httpConnection = nil
+    noteDelta = nil
     httpState = "idle"
-    currentChunk = nil
     uploadedChunks = 0
     failedChunks = 0
     totalBytesUploaded = 0
     finalizeCallback = nil
+    partialText = ""
+    partialCursor = 0
+    needsStatusSync = false
+    lastPollTime = playdate.getCurrentTimeMilliseconds()
 
     -- Request network access permission
     if playdate.network and playdate.network.http then
@@ -67,25 +158,58 @@ function ChunkUploader.startSession()
     return sessionId
 end
 
--- Queue a chunk for upload
-function ChunkUploader.queueChunk(compressedData, chunkSeq)
+-- Queue a spooled chunk for upload (by sequence number; the data stays on disk)
+function ChunkUploader.queueChunk(chunkSeq)
     if not isEnabled or not sessionId then
         return false
     end
 
     table.insert(uploadQueue, {
-        data = compressedData,
         seq = chunkSeq,
         retries = 0,
-        size = #compressedData
+        retryAt = 0
     })
 
     return true
 end
 
--- Start uploading the next chunk in queue
-local function startNextUpload()
-    if #uploadQueue == 0 or httpConnection then
+-- Put a chunk back at the front of the queue; after MAX_RETRIES it goes to the
+-- back and waits RETRY_BACKOFF_MS (it's safe on the spool, so never given up)
+local function retryChunk(chunk)
+    needsStatusSync = true  -- The server may have it even though we saw no ack
+    chunk.retries = chunk.retries + 1
+    if chunk.retries < MAX_RETRIES then
+        table.insert(uploadQueue, 1, chunk)
+    else
+        chunk.retries = 0
+        chunk.retryAt = playdate.getCurrentTimeMilliseconds() + RETRY_BACKOFF_MS
+        table.insert(uploadQueue, chunk)
+    end
+end
+
+-- Take the first queued chunk that isn't backing off
+local function nextQueuedChunk()
+    local now = playdate.getCurrentTimeMilliseconds()
+    for i, chunk in ipairs(uploadQueue) do
+        if chunk.retryAt <= now then
+            return table.remove(uploadQueue, i)
+        end
+    end
+    return nil
+end
+
+-- Drop a slot's connection (a fresh one is opened for its next chunk)
+local function resetSlot(slot)
+    if slot.connection then
+        slot.connection:close()
+        slot.connection = nil
+    end
+    slot.chunk = nil
+end
+
+-- Start uploading the next chunk in queue on an idle slot
+local function startNextUpload(slot)
+    if #uploadQueue == 0 or slot.chunk then
         return
     end
 
@@ -95,47 +219,263 @@ local function startNextUpload()
         return
     end
 
-    currentChunk = table.remove(uploadQueue, 1)
-
     -- Parse server URL for host
     local host = serverUrl:match("https?://([^/]+)")
     if not host then
         print("ChunkUploader: Invalid server URL: " .. tostring(serverUrl))
-        failedChunks = failedChunks + 1
-        currentChunk = nil
         return
     end
 
-    -- Create HTTP connection
-    httpConnection = playdate.network.http.new(host, 443, true)
-    if not httpConnection then
-        print("ChunkUploader: Failed to create HTTP connection")
-        -- Retry
-        currentChunk.retries = currentChunk.retries + 1
-        if currentChunk.retries < MAX_RETRIES then
-            table.insert(uploadQueue, 1, currentChunk)
-        else
-            failedChunks = failedChunks + 1
-        end
-        currentChunk = nil
+    local chunk = nextQueuedChunk()
+    if not chunk then
+        return  -- Everything left is backing off
+    end
+
+    -- Read the chunk back from the spool (frame map + audio, ready to send)
+    local body, mapBytes, overlapFrames = AudioRecorder.readSpooledChunk(chunk.seq)
+    if not body then
+        print("ChunkUploader: Chunk " .. chunk.seq .. " missing from spool")
+        failedChunks = failedChunks + 1
         return
     end
+    chunk.size = #body - mapBytes
+
+    -- Reuse the slot's connection, or open one that stays alive across chunks
+    if not slot.connection then
+        slot.connection = playdate.network.http.new(host, 443, true)
+        if not slot.connection then
+            print("ChunkUploader: Failed to create HTTP connection")
+            retryChunk(chunk)
+            return
+        end
+        slot.connection:setKeepAlive(true)
+    end
 
     -- Set up headers
     local headers = {
         ["X-Session-Id"] = sessionId,
-        ["X-Chunk-Seq"] = tostring(currentChunk.seq),
-        ["Content-Type"] = "audio/mulaw"
+        ["X-Chunk-Seq"] = tostring(chunk.seq),
+        ["X-Sample-Rate"] = tostring(sampleRate),
+        ["X-Frame-Map-Bytes"] = tostring(mapBytes),
+        ["X-Overlap-Frames"] = tostring(overlapFrames),
+        ["Content-Type"] = contentType
     }
 
     -- Make POST request
-    print("ChunkUploader: Uploading chunk " .. currentChunk.seq .. " (" .. currentChunk.size .. " bytes)")
-    httpConnection:post("/chunk", headers, currentChunk.data)
+    print("ChunkUploader: Uploading chunk " .. chunk.seq .. " (" .. chunk.size .. " bytes)")
+    slot.connection:post("/chunk", headers, body)
+
+    slot.chunk = chunk
+    slot.startTime = playdate.getCurrentTimeMilliseconds()
+end
+
+-- Check an upload slot for a response, error or timeout
+local function updateUploadSlot(slot, now)
+    local chunk = slot.chunk
+    if not chunk then
+        return
+    end
+
+    -- Timeout or connection error (e.g. the server dropped an idle keep-alive)
+    local err = slot.connection:getError()
+    if err or now - slot.startTime > TIMEOUT_MS then
+        print("ChunkUploader: Chunk " .. chunk.seq .. " upload " .. (err and ("error: " .. err) or "timeout"))
+        resetSlot(slot)
+        retryChunk(chunk)
+        return
+    end
+
+    -- Check if response received
+    local status = slot.connection:getResponseStatus()
+    if not status then
+        return
+    end
 
-    httpState = "uploading"
+    -- Drain the response so the connection is ready for the next request
+    local available = slot.connection:getBytesAvailable()
+    if available > 0 then
+        slot.connection:read(available)
+    end
+
+    if status == 200 then
+        -- Success (connection stays open for the next chunk)
+        print("ChunkUploader: Chunk " .. chunk.seq .. " uploaded successfully")
+        uploadedChunks = uploadedChunks + 1
+        totalBytesUploaded = totalBytesUploaded + chunk.size
+        AudioRecorder.ackChunk(chunk.seq)
+        slot.chunk = nil
+    else
+        -- Error
+        print("ChunkUploader: Chunk upload failed with status " .. status)
+        resetSlot(slot)
+        retryChunk(chunk)
+    end
+end
+
+-- Start a GET on the control connection (for /partial and session status)
+local function startControlGet(path, state)
+    if httpConnection or not playdate.network or not playdate.network.http then
+        return
+    end
+
+    local host = serverUrl:match("https?://([^/]+)")
+    if not host then
+        return
+    end
+
+    httpConnection = playdate.network.http.new(host, 443, true)
+    if not httpConnection then
+        return
+    end
+
+    local headers = {
+        ["X-Session-Id"] = sessionId
+    }
+    httpConnection:get(path, headers)
+
+    httpState = state
     requestStartTime = playdate.getCurrentTimeMilliseconds()
 end
 
+-- Finish a control request: returns done, decoded JSON (200 only) and status (nil on timeout)
+local function finishControlRequest(now)
+    local status = httpConnection:getResponseStatus()
+    if not status and now - requestStartTime <= PARTIAL_TIMEOUT_MS then
+        return false  -- Still waiting
+    end
+
+    local body = ""
+    if status == 200 then
+        local available = httpConnection:getBytesAvailable()
+        if available > 0 then
+            body = httpConnection:read(available) or ""
+        end
+    end
+
+    httpConnection:close()
+    httpConnection = nil
+    httpState = "idle"
+
+    local success, data = pcall(json.decode, body)
+    return true, status == 200 and success and data or nil, status
+end
+
+-- How long a 429 asks us to wait (Retry-After header, else the body's retry_after)
+local function retryAfterMs(connection, body)
+    local headers = connection.getResponseHeaders and connection:getResponseHeaders()
+    local seconds = headers and tonumber(headers["Retry-After"] or headers["retry-after"])
+    if not seconds then
+        local success, data = pcall(json.decode, body)
+        seconds = success and type(data) == "table" and tonumber(data.retry_after)
+    end
+    return seconds and seconds * 1000 or BUSY_RETRY_MS
+end
+
+-- POST the next note change (if any) on the control connection
+local function startNoteSync(now)
+    local host = serverUrl:match("https?://([^/]+)")
+    if not host or not playdate.network or not playdate.network.http then
+        return
+    end
+
+    local delta = NotesStore.nextSync()
+    if not delta then
+        noteSyncAt = now + NOTE_SYNC_IDLE_MS
+        return
+    end
+
+    if not noteAccessRequested then
+        noteAccessRequested = true
+        playdate.network.http.requestAccess(host, 443, true, "CrankScribe backs up your notes to its server")
+    end
+
+    httpConnection = playdate.network.http.new(host, 443, true)
+    if not httpConnection then
+        noteSyncAt = now + noteSyncBackoff
+        return
+    end
+
+    local body
+    if delta.deleted then
+        body = json.encode({ deleted = true })
+    else
+        body = json.encode({ version = delta.version, base_version = delta.base_version, fields = delta.fields })
+    end
+    local headers = {
+        ["X-Device-Id"] = deviceId,
+        ["Content-Type"] = "application/json"
+    }
+    local secret = App.settings and App.settings.deviceSecret
+    if secret and secret ~= "" then
+        headers["X-Device-Secret"] = secret
+    end
+    httpConnection:post("/notes/" .. delta.id, headers, body)
+
+    noteDelta = delta
+    httpState = "noteSyncing"
+    requestStartTime = now
+end
+
+-- Record the server's answer to a note push (data is its JSON on a 200)
+local function finishNoteSync(status, data, now)
+    local delta = noteDelta
+    noteDelta = nil
+    if data and data.device_secret and App.settings then
+        -- First sync: the server's secret for this device, sent from now on
+        App.settings.deviceSecret = data.device_secret
+        SettingsStore.save(App.settings)
+    end
+    if status == 200 or status == 409 then
+        if status == 409 then
+            -- The server lost the version this delta was built on
+            NotesStore.markUnsynced(delta.id)
+        elseif delta.deleted then
+            NotesStore.markDeleteSynced(delta.id)
+        else
+            NotesStore.markSynced(delta.id, delta.version)
+        end
+        noteSyncBackoff = NOTE_SYNC_BACKOFF_MS
+        noteSyncAt = now + NOTE_SYNC_INTERVAL_MS
+    else
+        print("ChunkUploader: Note sync failed (" .. tostring(status) .. "), retrying in " .. noteSyncBackoff .. "ms")
+        noteSyncAt = now + noteSyncBackoff
+        noteSyncBackoff = math.min(noteSyncBackoff * 2, NOTE_SYNC_MAX_BACKOFF_MS)
+    end
+end
+
+-- Hand the finalize result to its callback and end the session
+local function finishFinalize(transcript, err, data)
+    if not err then
+        AudioRecorder.closeSpool()
+    end
+    httpState = "idle"
+    finalizeJobId = nil
+    sessionId = nil  -- Clear session after finalize
+    if finalizeCallback then
+        local callback = finalizeCallback
+        finalizeCallback = nil
+        callback(transcript, err, data)
+    end
+end
+
+-- Drop queued chunks the server already has (their ack was lost), so only
+-- the gaps are re-sent
+local function applySessionStatus(data)
+    local acked = {}
+    for _, seq in ipairs(data.acked or {}) do
+        acked[seq] = true
+    end
+    for i = #uploadQueue, 1, -1 do
+        local seq = uploadQueue[i].seq
+        if acked[seq] then
+            print("ChunkUploader: Server already has chunk " .. seq)
+            table.remove(uploadQueue, i)
+            AudioRecorder.ackChunk(seq)
+            uploadedChunks = uploadedChunks + 1
+        end
+    end
+end
+
 -- Start finalize request
 local function startFinalizeRequest()
     if httpConnection then
@@ -144,30 +484,21 @@ local function startFinalizeRequest()
 
     -- Check network availability
     if not playdate.network or not playdate.network.http then
-        if finalizeCallback then
-            finalizeCallback(nil, "Network not available")
-            finalizeCallback = nil
-        end
+        finishFinalize(nil, "Network not available")
         return
     end
 
     -- Parse server URL for host
     local host = serverUrl:match("https?://([^/]+)")
     if not host then
-        if finalizeCallback then
-            finalizeCallback(nil, "Invalid server URL")
-            finalizeCallback = nil
-        end
+        finishFinalize(nil, "Invalid server URL")
         return
     end
 
     -- Create HTTP connection
     httpConnection = playdate.network.http.new(host, 443, true)
     if not httpConnection then
-        if finalizeCallback then
-            finalizeCallback(nil, "Failed to create HTTP connection")
-            finalizeCallback = nil
-        end
+        finishFinalize(nil, "Failed to create HTTP connection")
         return
     end
 
@@ -191,58 +522,55 @@ function ChunkUploader.update()
 
     local now = playdate.getCurrentTimeMilliseconds()
 
+    -- Uploads: service every slot, then hand queued chunks to idle ones
+    for _, slot in ipairs(uploadSlots) do
+        updateUploadSlot(slot, now)
+    end
+    for _, slot in ipairs(uploadSlots) do
+        startNextUpload(slot)
+    end
+
     if httpState == "idle" then
-        -- Start next upload if queue not empty
-        if #uploadQueue > 0 then
-            startNextUpload()
+        if needsStatusSync and sessionId and #uploadQueue > 0 then
+            -- Find out what already arrived before re-sending
+            needsStatusSync = false
+            startControlGet("/session/" .. sessionId .. "/status", "syncing")
+        elseif #uploadQueue == 0 and busySlotCount() == 0 and sessionId and not finalizeCallback
+                and uploadedChunks > partialCursor and now - lastPollTime > PARTIAL_POLL_MS then
+            -- Poll for live text while uploads are idle and chunks are still
+            -- waiting to be transcribed
+            lastPollTime = now
+            startControlGet("/partial?cursor=" .. partialCursor, "polling")
+        elseif not sessionId and deviceId and now >= noteSyncAt then
+            -- Nothing else to do: back up note changes
+            startNoteSync(now)
         end
 
-    elseif httpState == "uploading" then
-        -- Check for timeout
-        if now - requestStartTime > TIMEOUT_MS then
-            print("ChunkUploader: Upload timeout")
-            if httpConnection then
-                httpConnection:close()
-                httpConnection = nil
-            end
-            -- Retry
-            if currentChunk then
-                currentChunk.retries = currentChunk.retries + 1
-                if currentChunk.retries < MAX_RETRIES then
-                    table.insert(uploadQueue, 1, currentChunk)
-                else
-                    failedChunks = failedChunks + 1
-                end
-                currentChunk = nil
-            end
-            httpState = "idle"
-            return
+    elseif httpState == "noteSyncing" then
+        local done, data, status = finishControlRequest(now)
+        if done then
+            finishNoteSync(status, data, now)
         end
 
-        -- Check if response received
-        local status = httpConnection:getResponseStatus()
-        if status then
-            if status == 200 then
-                -- Success
-                print("ChunkUploader: Chunk " .. currentChunk.seq .. " uploaded successfully")
-                uploadedChunks = uploadedChunks + 1
-                totalBytesUploaded = totalBytesUploaded + currentChunk.size
-            else
-                -- Error
-                print("ChunkUploader: Chunk upload failed with status " .. status)
-                currentChunk.retries = currentChunk.retries + 1
-                if currentChunk.retries < MAX_RETRIES then
-                    table.insert(uploadQueue, 1, currentChunk)
-                else
-                    failedChunks = failedChunks + 1
+    elseif httpState == "syncing" then
+        local done, data = finishControlRequest(now)
+        if done and data then
+            applySessionStatus(data)
+        end
+
+    elseif httpState == "polling" then
+        -- A poll is only a nicety - drop it rather than hold up uploads
+        local done, data = finishControlRequest(now)
+        if done then
+            if data and data.cursor then
+                partialCursor = data.cursor
+                if data.text and data.text ~= "" then
+                    partialText = partialText == "" and data.text or (partialText .. " " .. data.text)
+                    if partialCallback then
+                        partialCallback(data.text, partialText)
+                    end
                 end
             end
-
-            -- Clean up
-            httpConnection:close()
-            httpConnection = nil
-            currentChunk = nil
-            httpState = "idle"
         end
 
     elseif httpState == "finalizing" then
@@ -253,11 +581,7 @@ function ChunkUploader.update()
                 httpConnection:close()
                 httpConnection = nil
             end
-            httpState = "idle"
-            if finalizeCallback then
-                finalizeCallback(nil, "Request timeout")
-                finalizeCallback = nil
-            end
+            finishFinalize(nil, "Request timeout")
             return
         end
 
@@ -270,37 +594,101 @@ function ChunkUploader.update()
                 body = httpConnection:read(available) or ""
             end
 
+            local connection = httpConnection
             httpConnection:close()
             httpConnection = nil
             httpState = "idle"
 
-            if status == 200 then
-                -- Parse response
-                local success, data = pcall(json.decode, body)
-                if success and data then
-                    print("ChunkUploader: Finalize successful, got transcript")
-                    if finalizeCallback then
-                        finalizeCallback(data.transcript, nil, data)
-                        finalizeCallback = nil
-                    end
-                else
-                    print("ChunkUploader: Failed to parse response: " .. tostring(body))
-                    if finalizeCallback then
-                        finalizeCallback(nil, "Failed to parse response")
-                        finalizeCallback = nil
-                    end
-                end
+            local success, data = pcall(json.decode, body)
+            if not success then
+                data = nil
+            end
+
+            if status == 202 and data and data.job_id then
+                -- Queued: poll the job rather than hold a request open
+                print("ChunkUploader: Finalize queued as job " .. data.job_id)
+                finalizeJobId = data.job_id
+                httpState = "awaitingJob"
+                jobWaitUntil = now + JOB_POLL_MS
+            elseif status == 429 then
+                -- Server busy: back off and send the finalize again
+                local wait = retryAfterMs(connection, body)
+                print("ChunkUploader: Server busy, finalizing again in " .. wait .. "ms")
+                httpState = "awaitingJob"
+                jobWaitUntil = now + wait
+            elseif status == 200 and data then
+                print("ChunkUploader: Finalize successful, got transcript")
+                finishFinalize(data.transcript, nil, data)
+            elseif status == 200 then
+                print("ChunkUploader: Failed to parse response: " .. tostring(body))
+                finishFinalize(nil, "Failed to parse response")
             else
                 print("ChunkUploader: Finalize failed with status " .. status .. ": " .. body)
-                if finalizeCallback then
-                    finalizeCallback(nil, "Server error: " .. status .. " - " .. body)
-                    finalizeCallback = nil
-                end
+                finishFinalize(nil, "Server error: " .. status .. " - " .. body)
+            end
+        end
+
+    elseif httpState == "awaitingJob" then
+        if now > jobDeadline then
+            print("ChunkUploader: Gave up waiting for finalize job")
+            finishFinalize(nil, "Transcription timeout")
+        elseif now >= jobWaitUntil then
+            -- If the connection can't be made, try again next interval
+            jobWaitUntil = now + JOB_POLL_MS
+            if finalizeJobId then
+                startControlGet("/job/" .. finalizeJobId, "jobPolling")
+            else
+                startFinalizeRequest()
+            end
+        end
+
+    elseif httpState == "jobPolling" then
+        local done, data, status = finishControlRequest(now)
+        if done then
+            if data and data.status == "done" then
+                print("ChunkUploader: Finalize successful, got transcript")
+                finishFinalize(data.transcript, nil, data)
+            elseif data and data.status == "error" then
+                print("ChunkUploader: Finalize job failed: " .. tostring(data.error))
+                finishFinalize(nil, "Server error: " .. tostring(data.http_status) .. " - " .. tostring(data.error))
+            elseif status == 404 then
+                finishFinalize(nil, "Finalize job not found")
+            else
+                -- Still queued or running (or the poll timed out): ask again shortly
+                httpState = "awaitingJob"
             end
+        end
+    end
+end
+
+-- Wait for the upload queue to drain (and any live transcript poll to
+-- finish), then POST /finalize. Past the deadline the wait gives up with an
+-- error; the chunks stay on the spool and the session stays open (uploads
+-- keep retrying), so finalize can simply be called again.
+local function finalizeWhenDrained(callback, deadline)
+    if finalizeCallback ~= callback then
+        return  -- Cancelled while waiting
+    end
 
-            sessionId = nil  -- Clear session after finalize
+    if #uploadQueue > 0 or busySlotCount() > 0 or httpState == "polling" or httpState == "syncing" then
+        if playdate.getCurrentTimeMilliseconds() > deadline then
+            local left = #uploadQueue + busySlotCount()
+            print("ChunkUploader: Gave up waiting for " .. left .. " chunks to upload")
+            finalizeCallback = nil
+            callback(nil, "Upload stalled: " .. left .. " chunks not sent yet")
+            return
         end
+        playdate.timer.performAfterDelay(100, function()
+            finalizeWhenDrained(callback, deadline)
+        end)
+        return
     end
+
+    -- Ready to finalize (no more chunks, so the upload connections can go)
+    closeUploadSlots()
+    finalizeJobId = nil
+    jobDeadline = playdate.getCurrentTimeMilliseconds() + JOB_DEADLINE_MS
+    startFinalizeRequest()
 end
 
 -- Finalize session and get transcript
@@ -315,109 +703,188 @@ function ChunkUploader.finalize(callback)
         return
     end
 
-    -- Wait for upload queue to drain
-    if #uploadQueue > 0 or httpState == "uploading" then
-        -- Queue is not empty, wait and retry
-        finalizeCallback = callback
-        playdate.timer.performAfterDelay(100, function()
-            ChunkUploader.finalize(callback)
-        end)
-        return
-    end
-
-    -- Ready to finalize
     finalizeCallback = callback
-    startFinalizeRequest()
+    finalizeWhenDrained(callback, playdate.getCurrentTimeMilliseconds() + JOB_DEADLINE_MS)
 end
 
--- Process transcript with LLM (summary, minutes, todos)
-function ChunkUploader.process(transcript, action, callback)
-    if not isEnabled then
-        callback(nil, "Uploader not enabled")
+-- Read a finished response off a timer-polled connection and close it
+local function readResponse(http)
+    local body = ""
+    local available = http:getBytesAvailable()
+    if available > 0 then
+        body = http:read(available) or ""
+    end
+    http:close()
+    local success, data = pcall(json.decode, body)
+    return body, success and type(data) == "table" and data or nil
+end
+
+-- Poll GET /job/<id> (a fresh connection each time) until the job finishes:
+-- callback(data, err), data being the job's result fields. With onText the
+-- polls long-poll for streamed text, passed on as onText(newText, fullText).
+local function pollJob(host, jobId, deadline, callback, onText, cursor, fullText)
+    local http = playdate.network.http.new(host, 443, true)
+    if not http then
+        callback(nil, "Failed to create HTTP connection")
         return
     end
+    cursor = cursor or 0
+    fullText = fullText or ""
+    if onText then
+        http:get("/job/" .. jobId .. "?cursor=" .. cursor .. "&wait=" .. JOB_WAIT_SECONDS)
+    else
+        http:get("/job/" .. jobId)
+    end
 
-    -- This still uses the old approach - could be converted to polling too
-    -- For now, use a simple synchronous-style approach
+    local startTime = playdate.getCurrentTimeMilliseconds()
+    local checkResponse
+    checkResponse = function()
+        local now = playdate.getCurrentTimeMilliseconds()
+        local status = http:getResponseStatus()
+        if not status and now - startTime <= PARTIAL_TIMEOUT_MS then
+            playdate.timer.performAfterDelay(100, checkResponse)
+            return
+        end
 
-    local host = serverUrl:match("https?://([^/]+)")
-    if not host then
-        callback(nil, "Invalid server URL")
-        return
+        local _, data = readResponse(http)
+        if status == 200 and data and data.status == "done" then
+            callback(data, nil)
+        elseif status == 200 and data and data.status == "error" then
+            callback(nil, "Server error: " .. tostring(data.http_status) .. " - " .. tostring(data.error))
+        elseif status == 404 then
+            callback(nil, "Job not found")
+        elseif now > deadline then
+            callback(nil, "Request timeout")
+        else
+            if onText and data and data.text and data.text ~= "" then
+                fullText = fullText .. data.text
+                cursor = data.cursor or cursor
+                onText(data.text, fullText)
+            end
+            -- A long-poll already waited on the server, so ask again at once
+            playdate.timer.performAfterDelay(onText and 100 or JOB_POLL_MS, function()
+                pollJob(host, jobId, deadline, callback, onText, cursor, fullText)
+            end)
+        end
     end
 
+    playdate.timer.performAfterDelay(100, checkResponse)
+end
+
+-- POST /process, then follow its job (re-POSTing after a 429) until the deadline
+local function postProcess(host, body, deadline, callback, onText)
     local http = playdate.network.http.new(host, 443, true)
     if not http then
         callback(nil, "Failed to create HTTP connection")
         return
     end
 
-    local body = json.encode({
-        action = action,
-        text = transcript
-    })
-
     local headers = {
         ["Content-Type"] = "application/json"
     }
 
     http:post("/process", headers, body)
 
-    -- For process, we'll use a timer-based polling approach
-    local checkResponse
     local startTime = playdate.getCurrentTimeMilliseconds()
-
+    local checkResponse
     checkResponse = function()
+        local now = playdate.getCurrentTimeMilliseconds()
         local status = http:getResponseStatus()
-        if status then
-            local responseBody = ""
-            local available = http:getBytesAvailable()
-            if available > 0 then
-                responseBody = http:read(available) or ""
-            end
-            http:close()
-
-            if status == 200 then
-                local success, data = pcall(json.decode, responseBody)
-                if success and data then
-                    callback(data.result, nil)
-                else
-                    callback(nil, "Failed to parse response")
-                end
+        if not status then
+            if now - startTime > TIMEOUT_MS then
+                http:close()
+                callback(nil, "Request timeout")
             else
-                callback(nil, "Server error: " .. status)
+                playdate.timer.performAfterDelay(100, checkResponse)
             end
-        elseif playdate.getCurrentTimeMilliseconds() - startTime > 60000 then
-            -- 60 second timeout for processing
-            http:close()
-            callback(nil, "Request timeout")
+            return
+        end
+
+        local responseBody, data = readResponse(http)
+        if status == 202 and data and data.job_id then
+            pollJob(host, data.job_id, deadline, function(result, err)
+                callback(result and result.result, err, result and result.results)
+            end, onText)
+        elseif status == 429 and now < deadline then
+            playdate.timer.performAfterDelay(retryAfterMs(http, responseBody), function()
+                postProcess(host, body, deadline, callback, onText)
+            end)
+        elseif status == 200 and data then
+            -- Every action was already cached on the server
+            callback(data.result, nil, data.results)
+        elseif status == 200 then
+            callback(nil, "Failed to parse response")
         else
-            -- Keep polling
-            playdate.timer.performAfterDelay(100, checkResponse)
+            callback(nil, "Server error: " .. status)
         end
     end
 
     playdate.timer.performAfterDelay(100, checkResponse)
 end
 
+-- Process transcript with LLM (summary, minutes, todos)
+-- action is one action or a list of them (done in one server call):
+-- callback(result, err, results), result for the first action and results
+-- mapping each action to its text. The first action's text streams to
+-- onText(newText, fullText) (optional) while it's being written.
+function ChunkUploader.process(transcript, action, callback, onText)
+    if not isEnabled then
+        callback(nil, "Uploader not enabled")
+        return
+    end
+
+    if not playdate.network or not playdate.network.http then
+        callback(nil, "Network not available")
+        return
+    end
+
+    local host = serverUrl:match("https?://([^/]+)")
+    if not host then
+        callback(nil, "Invalid server URL")
+        return
+    end
+
+    local body = json.encode({
+        actions = type(action) == "table" and action or { action },
+        text = transcript
+    })
+
+    postProcess(host, body, playdate.getCurrentTimeMilliseconds() + JOB_DEADLINE_MS, callback, onText)
+end
+
+-- Register a callback for live transcript text: callback(newText, fullText)
+function ChunkUploader.onPartial(callback)
+    partialCallback = callback
+end
+
+-- Get live transcript text received so far
+function ChunkUploader.getPartialTranscript()
+    return partialText
+end
+
 -- Cancel current session
 function ChunkUploader.cancel()
     if httpConnection then
         httpConnection:close()
         httpConnection = nil
     end
+    closeUploadSlots()
+    AudioRecorder.closeSpool()
     sessionId = nil
     uploadQueue = {}
-    currentChunk = nil
     httpState = "idle"
     finalizeCallback = nil
+    finalizeJobId = nil
+    noteDelta = nil
 end
 
 -- Get upload status
 function ChunkUploader.getStatus()
     return {
         sessionId = sessionId,
-        isUploading = httpState == "uploading",
+        isUploading = busySlotCount() > 0,
+        uploadsInFlight = busySlotCount(),
+        partialCursor = partialCursor,
         queueSize = #uploadQueue,
         uploadedChunks = uploadedChunks,
         failedChunks = failedChunks,
@@ -434,7 +901,7 @@ end
 
 -- Get progress percentage (0-100)
 function ChunkUploader.getProgress()
-    local total = uploadedChunks + failedChunks + #uploadQueue + (currentChunk and 1 or 0)
+    local total = uploadedChunks + failedChunks + #uploadQueue + busySlotCount()
     if total == 0 then return 100 end
     return math.floor((uploadedChunks / total) * 100)
 end
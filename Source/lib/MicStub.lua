@@ -7,11 +7,20 @@ if mic == nil then
     local _isRecording = false
     local _startTime = 0
     local _level = 0
+    local _peak = 0
+    local _peakHoldUntil = 0
+    local _backupPath = nil
+    local _sampleRate = 8000
+    local _codec = "mulaw"
+    local _chunkDuration = 30
+    local _chunkOverlapMs = 0
 
-    function mic.startRecording()
+    function mic.startRecording(backupPath)
+        _backupPath = backupPath
         _isRecording = true
         _startTime = playdate.getCurrentTimeMilliseconds()
         _level = 0
+        _peak = 0
         return true
     end
 
@@ -19,15 +28,67 @@ if mic == nil then
         _isRecording = false
         -- Return dummy WAV data (just a header for testing)
         local duration = (playdate.getCurrentTimeMilliseconds() - _startTime) / 1000
+        if _backupPath then
+            return _backupPath, duration
+        end
         return "RIFF....WAVEfmt ................data....", duration
     end
 
-    function mic.getLevel()
+    function mic.update()
+    end
+
+    function mic.setSampleRate(rate)
+        if _isRecording or (rate ~= 8000 and rate ~= 16000) then
+            return false
+        end
+        _sampleRate = rate
+        return true
+    end
+
+    function mic.getSampleRate()
+        return _sampleRate
+    end
+
+    function mic.setCodec(name)
+        if _isRecording or (name ~= "mulaw" and name ~= "adpcm") then
+            return false
+        end
+        _codec = name
+        return true
+    end
+
+    function mic.getCodec()
+        return _codec
+    end
+
+    function mic.setChunkDuration(seconds, overlapMs)
+        overlapMs = overlapMs or 0
+        if _isRecording or seconds < 5 or seconds > 60 or overlapMs < 0 or overlapMs > 500 then
+            return false
+        end
+        _chunkDuration = seconds
+        _chunkOverlapMs = overlapMs - overlapMs % 20
+        return true
+    end
+
+    function mic.getChunkDuration()
+        return _chunkDuration, _chunkOverlapMs
+    end
+
+    function mic.getLevels()  -- rms, peak, speech
         if _isRecording then
             -- Simulate varying mic level
             _level = math.abs(math.sin(playdate.getCurrentTimeMilliseconds() / 200)) * 0.7
+            -- Peak hold and decay like the C meter
+            local now = playdate.getCurrentTimeMilliseconds()
+            if _level * 1.4 >= _peak then
+                _peak = math.min(_level * 1.4, 1)
+                _peakHoldUntil = now + 500
+            elseif now > _peakHoldUntil then
+                _peak = _peak - (_peak - _level) / 8
+            end
         end
-        return _level
+        return _level, _peak, _isRecording and _level > 0.1
     end
 
     function mic.isRecording()
@@ -38,10 +99,41 @@ if mic == nil then
         return false
     end
 
-    function mic.getChunk()
+    function mic.getChunk()  -- data, seq, frameMap, overlapFrames
         return nil
     end
 
+    function mic.poll()  -- rms, peak, speech, duration, pending, sequence, encodedBytes, droppedBytes
+        local rms, peak, speech = mic.getLevels()
+        return rms, peak, speech, mic.getDuration(), 0, 0, 0, 0
+    end
+
+    function mic.getStats()  -- callbacks, avg/min/maxUs, chunksLost, framesLost, oom, backupDropped, kept, dropped, mulaw, adpcm
+        return 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    end
+
+    function mic.setPoolSize(kb)
+        return not _isRecording
+    end
+
+    function mic.getPoolSize()  -- sizeKB, usedKB
+        return 0, 0
+    end
+
+    function mic.getSpooledSequence()
+        return 0, 0
+    end
+
+    function mic.spoolRead(seq)  -- body, mapBytes, overlapFrames
+        return nil
+    end
+
+    function mic.spoolAck(seq)
+    end
+
+    function mic.spoolClose()
+    end
+
     function mic.getDuration()
         if _isRecording then
             return (playdate.getCurrentTimeMilliseconds() - _startTime) / 1000
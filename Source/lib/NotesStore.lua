@@ -1,8 +1,33 @@
 -- NotesStore: CRUD operations for notes
+-- Each note is its own datastore file; a separate index holds just what
+-- lists need (id, date, duration, preview, which modes exist), so browsing
+-- never parses transcripts. Full notes are loaded on open (NotesStore.get).
+-- Processed modes (summary, minutes, todos) live in small files of their own,
+-- so filling one in never rewrites the transcript.
+--
+-- Every change bumps the note's version in the index and marks which fields
+-- changed since the server last acknowledged it; ChunkUploader pushes those
+-- deltas in the background (NotesStore.nextSync / markSynced) as a backup.
 
 NotesStore = {}
 
 local NOTES_DIR = "notes"
+local INDEX_PATH = "notes_index"  -- Outside NOTES_DIR so listFiles only sees notes
+local LAYOUT_DIR = "layouts"      -- NoteView's wrapped lines, one file per note
+local DERIVED_DIR = "derived"     -- Processed modes, one file per note and mode
+local PREVIEW_LENGTH = 60         -- Transcript characters kept in the index
+local MODES = { "summary", "minutes", "todos" }
+local CORE_FIELDS = { "created_at", "duration_seconds", "transcript" }  -- Kept in the note file
+
+local isMode = {}
+for _, mode in ipairs(MODES) do
+    isMode[mode] = true
+end
+
+-- Index entries, newest first (loaded on first use)
+local index = nil
+-- Deleted note ids the server may still have (sent as deletes by the sync)
+local tombstones = nil
 
 -- Generate a unique ID
 local function generateId()
@@ -12,6 +37,124 @@ local function generateId()
         time.hour, time.minute, time.second)
 end
 
+-- Index entry for a note. Sync state rides along: version (bumped on every
+-- change), synced (last version the server acknowledged, 0 for none) and
+-- dirty (fields changed since then, or true for the whole note)
+local function makeEntry(note, previous)
+    local entry = {
+        id = note.id,
+        created_at = note.created_at,
+        duration_seconds = note.duration_seconds,
+        preview = string.sub(note.transcript or "", 1, PREVIEW_LENGTH),
+        version = previous and previous.version or 1,
+        synced = previous and previous.synced or 0,
+        dirty = not previous or previous.dirty,
+    }
+    for _, mode in ipairs(MODES) do
+        entry["has_" .. mode] = note[mode] ~= nil and note[mode] ~= ""
+    end
+    return entry
+end
+
+local function derivedPath(id, mode)
+    return DERIVED_DIR .. "/" .. id .. "_" .. mode
+end
+
+local function ensureDir(dir)
+    if not playdate.file.isdir(dir) then
+        playdate.file.mkdir(dir)
+    end
+end
+
+local function writeDerived(id, mode, text)
+    if text == nil then
+        playdate.datastore.delete(derivedPath(id, mode))
+        return
+    end
+    ensureDir(DERIVED_DIR)
+    playdate.datastore.write({ text = text }, derivedPath(id, mode))
+end
+
+-- Write a whole note: the note file (everything but the processed modes)
+-- and a file per mode it has
+local function writeNote(note)
+    ensureDir(NOTES_DIR)
+    local core = { id = note.id }
+    for _, key in ipairs(CORE_FIELDS) do
+        core[key] = note[key]
+    end
+    playdate.datastore.write(core, NOTES_DIR .. "/" .. note.id)
+
+    for _, mode in ipairs(MODES) do
+        if note[mode] ~= nil then
+            writeDerived(note.id, mode, note[mode])
+        end
+    end
+end
+
+local function sortIndex()
+    -- Sort by created_at descending (newest first)
+    table.sort(index, function(a, b)
+        return a.created_at > b.created_at
+    end)
+end
+
+local function writeIndex()
+    playdate.datastore.write({ notes = index, deleted = tombstones }, INDEX_PATH)
+end
+
+-- Build the index from the note files (first run, or if it went missing)
+local function rebuildIndex()
+    index = {}
+    tombstones = tombstones or {}
+
+    if playdate.file.isdir(NOTES_DIR) then
+        for _, filename in ipairs(playdate.file.listFiles(NOTES_DIR) or {}) do
+            -- Skip directories and hidden files
+            if not string.match(filename, "^%.") and not string.match(filename, "/$") then
+                local id = string.gsub(filename, "%.json$", "")
+                local note = NotesStore.load(id)
+                if note then
+                    table.insert(index, makeEntry(note))
+                end
+            end
+        end
+    end
+
+    sortIndex()
+    writeIndex()
+end
+
+local function getIndex()
+    if not index then
+        local data = playdate.datastore.read(INDEX_PATH)
+        if data and data.notes then
+            index = data.notes
+            tombstones = data.deleted or {}
+            for _, entry in ipairs(index) do
+                -- Notes from before sync have no version: back them up whole
+                if not entry.version then
+                    entry.version = 1
+                    entry.synced = 0
+                    entry.dirty = true
+                end
+            end
+        else
+            rebuildIndex()
+        end
+    end
+    return index
+end
+
+local function findEntry(id)
+    for i, entry in ipairs(getIndex()) do
+        if entry.id == id then
+            return i
+        end
+    end
+    return nil
+end
+
 -- Create a new note
 function NotesStore.create(transcript, duration)
     local time = playdate.getTime()
@@ -32,86 +175,247 @@ function NotesStore.create(transcript, duration)
     return note
 end
 
--- Save a note
+-- Record a change in the index: the next version, with the changed fields
+-- (a set, or true for everything) added to what the server hasn't seen
+local function recordChange(note, changed)
+    local i = findEntry(note.id)
+    local entry = makeEntry(note, i and index[i])
+    if i then
+        entry.version = entry.version + 1
+        if changed == true or entry.dirty == true or entry.synced == 0 then
+            entry.dirty = true
+        else
+            local dirty = entry.dirty or {}
+            for key in pairs(changed) do
+                dirty[key] = true
+            end
+            entry.dirty = dirty
+        end
+        index[i] = entry
+    else
+        table.insert(index, entry)
+        sortIndex()
+    end
+    writeIndex()
+end
+
+-- Save a whole note (the note file and every processed mode it has)
 function NotesStore.save(note)
     if not note or not note.id then
         return false
     end
 
-    -- Ensure notes directory exists
-    if not playdate.file.isdir(NOTES_DIR) then
-        playdate.file.mkdir(NOTES_DIR)
-    end
-
-    local path = NOTES_DIR .. "/" .. note.id
-    playdate.datastore.write(note, path)
+    writeNote(note)
+    recordChange(note, true)
     return true
 end
 
--- Load a note by ID
+-- Load a note by ID (the note file with its processed modes merged in; notes
+-- saved before modes had their own files keep them in the note file)
 function NotesStore.load(id)
-    local path = NOTES_DIR .. "/" .. id
-    return playdate.datastore.read(path)
+    local note = playdate.datastore.read(NOTES_DIR .. "/" .. id)
+    if not note then
+        return nil
+    end
+    for _, mode in ipairs(MODES) do
+        local derived = playdate.datastore.read(derivedPath(id, mode))
+        if derived then
+            note[mode] = derived.text
+        end
+    end
+    return note
 end
 
--- List all notes (returns array sorted by date, newest first)
-function NotesStore.list()
-    local notes = {}
-
-    if not playdate.file.isdir(NOTES_DIR) then
-        return notes
+-- The full note for a note or index entry (entries are loaded from disk)
+function NotesStore.get(note)
+    if not note or note.transcript then
+        return note
     end
+    return NotesStore.load(note.id)
+end
 
-    local files = playdate.file.listFiles(NOTES_DIR)
-    if not files then
-        return notes
-    end
+-- List all notes (returns array sorted by date, newest first)
+-- These are index entries (no transcript or processed text); use
+-- NotesStore.get for the full note
+function NotesStore.list()
+    return NotesStore.listRange(1, NotesStore.count())
+end
 
-    for _, filename in ipairs(files) do
-        -- Skip directories and hidden files
-        if not string.match(filename, "^%.") and not string.match(filename, "/$") then
-            local id = string.gsub(filename, "%.json$", "")
-            local note = NotesStore.load(id)
-            if note then
-                table.insert(notes, note)
-            end
+-- Index entries first .. first + count - 1 (1-based, newest first), for
+-- screens that page through the list rather than take all of it
+function NotesStore.listRange(first, count)
+    local notes = {}
+    local all = getIndex()
+    for i = first, math.min(first + count - 1, #all) do
+        -- Copies, so callers can't change the index by accident
+        local copy = {}
+        for key, value in pairs(all[i]) do
+            copy[key] = value
         end
+        table.insert(notes, copy)
     end
-
-    -- Sort by created_at descending (newest first)
-    table.sort(notes, function(a, b)
-        return a.created_at > b.created_at
-    end)
-
     return notes
 end
 
 -- Delete a note by ID
 function NotesStore.delete(id)
-    local path = NOTES_DIR .. "/" .. id .. ".json"
     playdate.datastore.delete(NOTES_DIR .. "/" .. id)
+    playdate.datastore.delete(LAYOUT_DIR .. "/" .. id)
+    for _, mode in ipairs(MODES) do
+        playdate.datastore.delete(derivedPath(id, mode))
+    end
+
+    local i = findEntry(id)
+    if i then
+        -- A note the server has is deleted there too (one mid-push is
+        -- caught by markSynced)
+        if index[i].synced > 0 then
+            table.insert(tombstones, id)
+        end
+        table.remove(index, i)
+        writeIndex()
+    end
     return true
 end
 
--- Update specific fields of a note
+-- Update specific fields of a note. Only what changed is written: a
+-- processed mode rewrites its own small file, and the note file (transcript)
+-- is rewritten only when one of its fields changes - along with the modes,
+-- which moves them out of notes saved before they had files of their own.
 function NotesStore.update(id, fields)
     local note = NotesStore.load(id)
     if not note then
         return nil
     end
 
+    local changed = {}
+    local coreChanged = false
     for key, value in pairs(fields) do
-        note[key] = value
+        if note[key] ~= value then
+            note[key] = value
+            changed[key] = true
+            if isMode[key] then
+                writeDerived(id, key, value)
+            else
+                coreChanged = true
+            end
+        end
     end
 
-    NotesStore.save(note)
+    if next(changed) then
+        if coreChanged then
+            writeNote(note)
+        end
+        recordChange(note, changed)
+    end
     return note
 end
 
+-- The oldest change the server hasn't acknowledged, as a sync delta, or nil:
+-- { id, version, base_version, fields } with just the fields changed since
+-- base_version (base_version 0 and every field when the server has none of
+-- it), or { id, deleted = true } for a deleted note
+function NotesStore.nextSync()
+    local all = getIndex()
+    if #tombstones > 0 then
+        return { id = tombstones[1], deleted = true }
+    end
+
+    for i = #all, 1, -1 do
+        local entry = all[i]
+        if entry.dirty then
+            local note = NotesStore.load(entry.id)
+            if note then
+                local full = entry.dirty == true or entry.synced == 0
+                local fields = {}
+                for _, key in ipairs(CORE_FIELDS) do
+                    if full or entry.dirty[key] then
+                        fields[key] = note[key]
+                    end
+                end
+                for _, mode in ipairs(MODES) do
+                    if full or entry.dirty[mode] then
+                        fields[mode] = note[mode] or ""
+                    end
+                end
+                return {
+                    id = entry.id,
+                    version = entry.version,
+                    base_version = full and 0 or entry.synced,
+                    fields = fields,
+                }
+            end
+        end
+    end
+    return nil
+end
+
+-- The server has a note at version (changes made since stay dirty)
+function NotesStore.markSynced(id, version)
+    local i = findEntry(id)
+    if not i then
+        -- Deleted while its push was in flight: delete it there too
+        table.insert(tombstones, id)
+        writeIndex()
+        return
+    end
+    local entry = index[i]
+    entry.synced = version
+    if entry.version == version then
+        entry.dirty = nil
+    end
+    writeIndex()
+end
+
+-- The server lacks the version a delta was built on: send the whole note
+function NotesStore.markUnsynced(id)
+    local i = findEntry(id)
+    if i then
+        index[i].synced = 0
+        index[i].dirty = true
+        writeIndex()
+    end
+end
+
+-- The server has dropped a deleted note
+function NotesStore.markDeleteSynced(id)
+    getIndex()
+    for i = #tombstones, 1, -1 do
+        if tombstones[i] == id then
+            table.remove(tombstones, i)
+        end
+    end
+    writeIndex()
+end
+
+-- Saved text layout for one of a note's modes (see NoteView), or nil
+function NotesStore.loadLayout(id, mode)
+    local layouts = playdate.datastore.read(LAYOUT_DIR .. "/" .. id)
+    return layouts and layouts[mode]
+end
+
+function NotesStore.saveLayout(id, mode, layout)
+    if not playdate.file.isdir(LAYOUT_DIR) then
+        playdate.file.mkdir(LAYOUT_DIR)
+    end
+
+    local path = LAYOUT_DIR .. "/" .. id
+    local layouts = playdate.datastore.read(path) or {}
+    layouts[mode] = layout
+    playdate.datastore.write(layouts, path)
+end
+
 -- Get note count
 function NotesStore.count()
-    local notes = NotesStore.list()
-    return #notes
+    return #getIndex()
+end
+
+-- Whether a note (or index entry) has a processed mode's text
+function NotesStore.hasMode(note, mode)
+    if note[mode] ~= nil then
+        return note[mode] ~= ""
+    end
+    return note["has_" .. mode] == true
 end
 
 -- Format duration for display (e.g., "2:34")
@@ -128,11 +432,11 @@ end
 -- Get a short preview of transcript
 function NotesStore.getPreview(note, maxLen)
     maxLen = maxLen or 50
-    if not note or not note.transcript then
+    local text = note and (note.transcript or note.preview)
+    if not text then
         return ""
     end
 
-    local text = note.transcript
     if #text <= maxLen then
         return text
     end
@@ -79,8 +79,8 @@ local function getMockProcessed(mode, transcript)
     return transcript
 end
 
--- Transcribe audio using Whisper API (mock in simulator)
-function OpenAI.transcribe(wavData, callback)
+-- Transcribe a backup WAV file using Whisper API (mock in simulator)
+function OpenAI.transcribe(wavPath, callback)
     local apiKey = App.settings and App.settings.apiKey
 
     if not apiKey or apiKey == "" then
@@ -88,7 +88,7 @@ function OpenAI.transcribe(wavData, callback)
         return
     end
 
-    if not wavData then
+    if not wavPath then
         callback(nil, "No audio data provided")
         return
     end
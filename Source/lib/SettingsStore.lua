@@ -9,9 +9,24 @@ local defaults = {
     apiKey = "",
     serverUrl = "https://crankscribe-api-2f2fa5f92127.herokuapp.com",  -- CrankScribe transcription server URL
     micInput = "internal",  -- "internal" or "headset"
+    sampleRate = 8000,      -- Upload sample rate: 8000 (smaller) or 16000 (wideband)
+    codec = "mulaw",        -- Upload codec: "mulaw" (8-bit) or "adpcm" (4-bit, half the bytes)
+    chunkDuration = 10,     -- Seconds per uploaded chunk (5-60); shorter = faster transcript at stop
+    chunkOverlapMs = 200,   -- Audio repeated at the start of each chunk (0-500 ms)
+    uploadSlots = 2,        -- Chunks uploaded in parallel (1-4) when catching up after a dropout
+    capturePoolKB = 2048,   -- Memory the mic extension carves every recording buffer from (256-8192)
+    deviceId = "",          -- Random id the server files this device's note backups under (made on first load)
+    deviceSecret = "",      -- Issued by the server on the first note sync; required to read backups back
     autoSave = true,
 }
 
+-- 16 random hex digits
+local function newDeviceId()
+    return (string.gsub(string.rep("x", 16), "x", function()
+        return string.format("%x", math.random(0, 15))
+    end))
+end
+
 -- Load settings from disk
 function SettingsStore.load()
     local data = playdate.datastore.read(SETTINGS_FILE)
@@ -22,10 +37,16 @@ function SettingsStore.load()
                 data[key] = value
             end
         end
-        return data
     else
-        return SettingsStore.copyDefaults()
+        data = SettingsStore.copyDefaults()
+    end
+
+    -- Saved at once so the id stays the same across launches
+    if data.deviceId == "" then
+        data.deviceId = newDeviceId()
+        SettingsStore.save(data)
     end
+    return data
 end
 
 -- Save settings to disk
@@ -69,6 +69,11 @@ App = {
 
 -- Initialize the app
 local function init()
+    -- Seed from the clock rather than trust the runtime's default seed: the
+    -- device id (settings) and session ids come from math.random
+    local seconds, milliseconds = playdate.getSecondsSinceEpoch()
+    math.randomseed(seconds * 1000 + milliseconds, playdate.getCurrentTimeMilliseconds())
+
     -- Set up display
     gfx.setBackgroundColor(gfx.kColorWhite)
     gfx.clear()
@@ -76,6 +81,9 @@ local function init()
     -- Check for api_key.txt file drop, then load settings
     SettingsStore.checkForApiKeyFile()
     App.settings = SettingsStore.load()
+    AudioRecorder.setPoolSize(App.settings.capturePoolKB)
+    ChunkUploader.init({ serverUrl = App.settings.serverUrl, uploadSlots = App.settings.uploadSlots,
+                         deviceId = App.settings.deviceId })
 
     -- Register all screens
     ScreenManager:register("mainMenu", MainMenu)
@@ -104,6 +112,9 @@ function playdate.update()
         ScreenManager.currentScreen:update()
     end
 
+    -- Poll uploads, finalize and the background note sync (every screen)
+    ChunkUploader.update()
+
     -- Draw current screen
     if ScreenManager.currentScreen and ScreenManager.currentScreen.draw then
         ScreenManager.currentScreen:draw()
@@ -6,11 +6,27 @@ NoteView = {}
 
 local note = nil
 local viewMode = "transcript"  -- "transcript" | "minutes" | "summary" | "todos"
-local contentLines = {}
 local scrollOffset = 0
 local maxVisibleLines = 8
 local lineHeight = 20
 
+-- Layout: wrapped lines are byte ranges of content (a blank line between
+-- paragraphs has start 0). It's computed once per text, font and width and
+-- saved with the note, and line text is only cut out for lines on screen.
+local LAYOUT_WIDTH <const> = 370
+local LAYOUT_FONT <const> = "system"  -- Part of the layout key
+local content = ""            -- Text being shown
+local lineStarts = {}
+local lineEnds = {}
+local lineCount = 0
+local lineCache = {}          -- Line index -> text, for lines drawn lately
+local cachedLines = 0
+
+-- Incremental wrapping (text appended while it streams in)
+local openLine = false        -- Last line's paragraph is unfinished, so it can still grow
+local paragraphDone = false   -- Last paragraph ended; the next word starts a new one
+local streaming = false       -- Content is still arriving (see NoteView:streamText)
+
 local modeTitles = {
     transcript = "Transcript",
     minutes = "Meeting Minutes",
@@ -18,80 +34,181 @@ local modeTitles = {
     todos = "To-Do List",
 }
 
+local function resetLayout()
+    content = ""
+    lineStarts = {}
+    lineEnds = {}
+    lineCount = 0
+    lineCache = {}
+    cachedLines = 0
+    openLine = false
+    paragraphDone = false
+end
+
+-- Identifies the text a saved layout was made for, without hashing all of it
+local function layoutKey(text)
+    return table.concat({ LAYOUT_FONT, LAYOUT_WIDTH, #text, text:sub(1, 64), text:sub(-64) }, "|")
+end
+
+local function addLine(first, last)
+    lineCount = lineCount + 1
+    lineStarts[lineCount] = first
+    lineEnds[lineCount] = last
+end
+
+-- Text of a wrapped line
+local function getLine(i)
+    local text = lineCache[i]
+    if not text then
+        if cachedLines >= maxVisibleLines * 4 then
+            lineCache = {}
+            cachedLines = 0
+        end
+        text = lineStarts[i] > 0 and content:sub(lineStarts[i], lineEnds[i]) or ""
+        lineCache[i] = text
+        cachedLines = cachedLines + 1
+    end
+    return text
+end
+
 -- Screen lifecycle
+-- data.streaming opens the view on text still being generated: data.text
+-- is what has arrived so far, and the rest comes via NoteView:streamText
 function NoteView:enter(data)
-    note = data and data.note or App.currentNote
+    -- Index entries (from NotesList) only get their text loaded here
+    note = NotesStore.get(data and data.note or App.currentNote)
     viewMode = data and data.viewMode or "transcript"
     scrollOffset = 0
-    contentLines = {}
+    streaming = data and data.streaming or false
 
-    self:wrapContent()
+    if streaming then
+        resetLayout()
+        self:streamText(note, viewMode, data.text or "")
+    else
+        self:wrapContent()
+    end
 end
 
 function NoteView:leave()
-    -- Nothing to clean up
+    streaming = false
+    resetLayout()
+end
+
+-- More generated text for a note's mode, if that's what is on screen
+function NoteView:streamText(forNote, mode, text)
+    if not streaming or forNote ~= note or mode ~= viewMode then
+        return
+    end
+    self:appendContent(text)
+end
+
+-- Generation finished (the note holds the final text, unless it failed -
+-- then what streamed stays on screen)
+function NoteView:finishStreaming(forNote, mode)
+    if not streaming or forNote ~= note or mode ~= viewMode then
+        return
+    end
+    streaming = false
+    local text = note and note[viewMode]
+    if text and text ~= content then
+        self:wrapContent()
+    elseif text then
+        NotesStore.saveLayout(note.id, viewMode, { key = layoutKey(content), starts = lineStarts, ends = lineEnds })
+    end
 end
 
 function NoteView:wrapContent()
-    contentLines = {}
+    resetLayout()
 
     if not note then return end
 
     -- Get content based on view mode
-    local content = ""
+    local text = ""
     if viewMode == "transcript" then
-        content = note.transcript or ""
+        text = note.transcript or ""
     elseif viewMode == "minutes" then
-        content = note.minutes or ""
+        text = note.minutes or ""
     elseif viewMode == "summary" then
-        content = note.summary or ""
+        text = note.summary or ""
     elseif viewMode == "todos" then
-        content = note.todos or ""
+        text = note.todos or ""
     end
 
-    if content == "" then
-        table.insert(contentLines, "No content available.")
+    if text == "" then
+        self:appendContent("No content available.")
         return
     end
 
-    -- Wrap text into lines
-    local maxWidth = 370
+    -- Reuse the layout saved with the note if it's for this text
+    local key = layoutKey(text)
+    local layout = NotesStore.loadLayout(note.id, viewMode)
+    if layout and layout.key == key then
+        content = text
+        lineStarts = layout.starts
+        lineEnds = layout.ends
+        lineCount = #lineStarts
+        return
+    end
+
+    self:appendContent(text)
+    NotesStore.saveLayout(note.id, viewMode, { key = key, starts = lineStarts, ends = lineEnds })
+end
+
+-- Wrap text onto the end of the content. Wrapping is greedy, so only the last
+-- line of an unfinished paragraph can change as text is appended: it is taken
+-- back and re-wrapped with the new text, and every line above stays as is.
+function NoteView:appendContent(text)
+    local from = #content + 1
+    if openLine then
+        from = lineStarts[lineCount]
+        lineStarts[lineCount] = nil
+        lineEnds[lineCount] = nil
+        lineCache[lineCount] = nil
+        lineCount = lineCount - 1
+        openLine = false
+    end
+    content = content .. text
 
     gfx.setFont(gfx.getSystemFont())
 
-    -- Split by newlines first, then wrap each paragraph
-    for paragraph in content:gmatch("[^\n]+") do
-        local words = {}
-        for word in paragraph:gmatch("%S+") do
-            table.insert(words, word)
+    local lineStart, lineEnd = nil, nil
+    local gapStart = from
+    for wordStart, wordEnd in content:gmatch("()%S+()", from) do
+        -- A newline between words ends the paragraph
+        if content:sub(gapStart, wordStart - 1):find("\n", 1, true) then
+            if lineStart then
+                addLine(lineStart, lineEnd)
+                lineStart = nil
+            end
+            paragraphDone = true
         end
 
-        local currentLine = ""
-        for _, word in ipairs(words) do
-            local testLine = currentLine == "" and word or (currentLine .. " " .. word)
-            local testWidth = gfx.getTextSize(testLine)
-
-            if testWidth > maxWidth then
-                if currentLine ~= "" then
-                    table.insert(contentLines, currentLine)
-                end
-                currentLine = word
-            else
-                currentLine = testLine
+        -- Blank line between paragraphs
+        if paragraphDone then
+            if lineCount > 0 then
+                addLine(0, 0)
             end
+            paragraphDone = false
         end
 
-        if currentLine ~= "" then
-            table.insert(contentLines, currentLine)
+        if not lineStart then
+            lineStart, lineEnd = wordStart, wordEnd - 1
+        elseif gfx.getTextSize(content:sub(lineStart, wordEnd - 1)) > LAYOUT_WIDTH then
+            addLine(lineStart, lineEnd)
+            lineStart, lineEnd = wordStart, wordEnd - 1
+        else
+            lineEnd = wordEnd - 1
         end
-
-        -- Add blank line between paragraphs
-        table.insert(contentLines, "")
+        gapStart = wordEnd
     end
 
-    -- Remove trailing blank line
-    if #contentLines > 0 and contentLines[#contentLines] == "" then
-        table.remove(contentLines)
+    local endsParagraph = content:find("\n", gapStart, true) ~= nil
+    if lineStart then
+        addLine(lineStart, lineEnd)
+        openLine = not endsParagraph
+    end
+    if endsParagraph then
+        paragraphDone = true
     end
 end
 
@@ -100,7 +217,7 @@ function NoteView:update()
     local change = playdate.getCrankChange()
     if change ~= 0 then
         scrollOffset = scrollOffset + change / 10
-        local maxScroll = math.max(0, #contentLines - maxVisibleLines)
+        local maxScroll = math.max(0, lineCount - maxVisibleLines)
         scrollOffset = math.max(0, math.min(scrollOffset, maxScroll))
     end
 end
@@ -147,23 +264,23 @@ function NoteView:drawContent()
 
     for i = 1, maxVisibleLines + 1 do
         local lineIndex = scrollInt + i
-        if lineIndex <= #contentLines then
+        if lineIndex <= lineCount then
             local y = startY + (i - 1) * lineHeight - scrollFrac * lineHeight
             if y >= startY - lineHeight and y < startY + maxVisibleLines * lineHeight then
-                gfx.drawText(contentLines[lineIndex], x, y)
+                gfx.drawText(getLine(lineIndex), x, y)
             end
         end
     end
 
     -- Scroll indicator
-    if #contentLines > maxVisibleLines then
+    if lineCount > maxVisibleLines then
         local scrollBarHeight = maxVisibleLines * lineHeight
         local scrollBarY = startY
         local scrollBarX = screenWidth - 8
 
-        local maxScroll = #contentLines - maxVisibleLines
+        local maxScroll = lineCount - maxVisibleLines
         local scrollPercent = maxScroll > 0 and (scrollOffset / maxScroll) or 0
-        local indicatorHeight = math.max(15, scrollBarHeight / #contentLines * maxVisibleLines)
+        local indicatorHeight = math.max(15, scrollBarHeight / lineCount * maxVisibleLines)
         local indicatorY = scrollBarY + (scrollBarHeight - indicatorHeight) * scrollPercent
 
         gfx.setColor(gfx.kColorBlack)
@@ -181,7 +298,7 @@ function NoteView:drawFooter()
     gfx.drawLine(0, y - 5, screenWidth, y - 5)
 
     gfx.setFont(gfx.getSystemFont())
-    local text = "Crank: scroll   B: back"
+    local text = streaming and "Writing...   B: back" or "Crank: scroll   B: back"
     local textWidth = gfx.getTextSize(text)
     gfx.drawText(text, (screenWidth - textWidth) / 2, y)
 end
@@ -199,7 +316,7 @@ function NoteView:upButtonDown()
 end
 
 function NoteView:downButtonDown()
-    local maxScroll = math.max(0, #contentLines - maxVisibleLines)
+    local maxScroll = math.max(0, lineCount - maxVisibleLines)
     scrollOffset = scrollOffset + 1
     if scrollOffset > maxScroll then
         scrollOffset = maxScroll
@@ -4,29 +4,73 @@ local gfx <const> = playdate.graphics
 
 NotesList = {}
 
-local notes = {}
+local noteCount = 0
 local selectedIndex = 1
 local scrollOffset = 0
 local maxVisibleItems = 5
 local spineHeight = 38
+local spineWidth = 360
+
+-- The index is read in pages, and only pages near the visible window are kept
+local PAGE_SIZE = 20
+local pages = {}              -- page number -> index entries
+
+-- Pre-rendered spines (drawing one is then a blit), by note id and kept
+-- only for notes near the window: { key, normal, selected }
+local spineCache = {}
 
 -- Screen lifecycle
 function NotesList:enter(data)
     selectedIndex = 1
     scrollOffset = 0
-    notes = NotesStore.list()
+    noteCount = NotesStore.count()
+    -- Notes may have changed since last time; spines are re-rendered when
+    -- their entry differs (see getSpine)
+    pages = {}
 end
 
 function NotesList:leave()
+    pages = {}
+    spineCache = {}
+end
+
+-- Index entry for a list position, paging it in if needed
+local function noteAt(index)
+    local page = (index - 1) // PAGE_SIZE
+    if not pages[page] then
+        pages[page] = NotesStore.listRange(page * PAGE_SIZE + 1, PAGE_SIZE)
+    end
+    return pages[page][(index - 1) % PAGE_SIZE + 1]
+end
+
+-- Drop pages and spines that scrolled well out of view
+local function trimCaches()
+    local firstPage = math.max(scrollOffset - PAGE_SIZE, 0) // PAGE_SIZE
+    local lastPage = (scrollOffset + maxVisibleItems + PAGE_SIZE) // PAGE_SIZE
+    for page in pairs(pages) do
+        if page < firstPage or page > lastPage then
+            pages[page] = nil
+        end
+    end
+
+    local keep = {}
+    for index = scrollOffset + 1, math.min(scrollOffset + maxVisibleItems, noteCount) do
+        keep[noteAt(index).id] = true
+    end
+    for id in pairs(spineCache) do
+        if not keep[id] then
+            spineCache[id] = nil
+        end
+    end
 end
 
 function NotesList:update()
     local ticks = playdate.getCrankTicks(4)
-    if ticks ~= 0 and #notes > 0 then
+    if ticks ~= 0 and noteCount > 0 then
         selectedIndex = selectedIndex + ticks
         if selectedIndex < 1 then
-            selectedIndex = #notes
-        elseif selectedIndex > #notes then
+            selectedIndex = noteCount
+        elseif selectedIndex > noteCount then
             selectedIndex = 1
         end
 
@@ -36,6 +80,7 @@ function NotesList:update()
         elseif selectedIndex > scrollOffset + maxVisibleItems then
             scrollOffset = selectedIndex - maxVisibleItems
         end
+        trimCaches()
     end
 end
 
@@ -44,7 +89,7 @@ function NotesList:draw()
 
     self:drawHeader()
 
-    if #notes == 0 then
+    if noteCount == 0 then
         self:drawEmpty()
     else
         self:drawTapeSpines()
@@ -66,8 +111,8 @@ function NotesList:drawHeader()
         gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
     end
     local title = "MY NOTES"
-    if #notes > 0 then
-        title = title .. " (" .. #notes .. ")"
+    if noteCount > 0 then
+        title = title .. " (" .. noteCount .. ")"
     end
     local titleWidth = gfx.getTextSize(title)
     gfx.drawText(title, (screenWidth - titleWidth) / 2, 16)
@@ -90,32 +135,50 @@ function NotesList:drawEmpty()
     gfx.drawText(text2, (screenWidth - text2Width) / 2, centerY + 15)
 end
 
+-- A note's spine image, rendered on first use and again if its entry changed
+function NotesList:getSpine(note, isSelected)
+    local key = note.created_at .. "|" .. tostring(note.duration_seconds) .. "|" .. (note.preview or "")
+    local cached = spineCache[note.id]
+    if not cached or cached.key ~= key then
+        cached = { key = key }
+        spineCache[note.id] = cached
+    end
+
+    local which = isSelected and "selected" or "normal"
+    if not cached[which] then
+        local image = gfx.image.new(spineWidth, spineHeight - 4)
+        gfx.pushContext(image)
+        self:drawTapeSpine(note, 0, 0, spineWidth, spineHeight - 4, isSelected)
+        gfx.popContext()
+        cached[which] = image
+    end
+    return cached[which]
+end
+
 function NotesList:drawTapeSpines()
     local screenWidth = 400
     local startY = 48
-    local spineWidth = screenWidth - 40
-
-    gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
 
+    -- Only the visible window is drawn, each spine a cached image
     for i = 1, maxVisibleItems do
         local noteIndex = scrollOffset + i
-        if noteIndex <= #notes then
-            local note = notes[noteIndex]
+        if noteIndex <= noteCount then
+            local note = noteAt(noteIndex)
             local y = startY + (i - 1) * spineHeight
             local isSelected = (noteIndex == selectedIndex)
 
-            self:drawTapeSpine(note, 20, y, spineWidth, spineHeight - 4, isSelected)
+            self:getSpine(note, isSelected):draw(20, y)
         end
     end
 
     -- Scroll indicators
-    if #notes > maxVisibleItems then
+    if noteCount > maxVisibleItems then
         gfx.setColor(gfx.kColorBlack)
         if scrollOffset > 0 then
             -- Up arrow
             gfx.fillTriangle(screenWidth - 15, startY + 5, screenWidth - 10, startY - 5, screenWidth - 5, startY + 5)
         end
-        if scrollOffset + maxVisibleItems < #notes then
+        if scrollOffset + maxVisibleItems < noteCount then
             -- Down arrow
             local bottomY = startY + maxVisibleItems * spineHeight - 10
             gfx.fillTriangle(screenWidth - 15, bottomY - 5, screenWidth - 10, bottomY + 5, screenWidth - 5, bottomY - 5)
@@ -171,16 +234,16 @@ function NotesList:drawFooter()
 
     gfx.setColor(gfx.kColorBlack)
     gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
-    local text = #notes > 0 and "CRANK: Scroll   A: Open   B: Back" or "B: Back"
+    local text = noteCount > 0 and "CRANK: Scroll   A: Open   B: Back" or "B: Back"
     local textWidth = gfx.getTextSize(text)
     gfx.drawText(text, (screenWidth - textWidth) / 2, y)
 end
 
 -- Input handlers
 function NotesList:AButtonDown()
-    if #notes == 0 then return end
+    if noteCount == 0 then return end
 
-    local note = notes[selectedIndex]
+    local note = noteAt(selectedIndex)
     if note then
         App.currentNote = note
         ScreenManager:switchTo("postRecording", { note = note })
@@ -192,25 +255,27 @@ function NotesList:BButtonDown()
 end
 
 function NotesList:upButtonDown()
-    if #notes == 0 then return end
+    if noteCount == 0 then return end
     selectedIndex = selectedIndex - 1
     if selectedIndex < 1 then
-        selectedIndex = #notes
-        scrollOffset = math.max(0, #notes - maxVisibleItems)
+        selectedIndex = noteCount
+        scrollOffset = math.max(0, noteCount - maxVisibleItems)
     end
     if selectedIndex <= scrollOffset then
         scrollOffset = selectedIndex - 1
     end
+    trimCaches()
 end
 
 function NotesList:downButtonDown()
-    if #notes == 0 then return end
+    if noteCount == 0 then return end
     selectedIndex = selectedIndex + 1
-    if selectedIndex > #notes then
+    if selectedIndex > noteCount then
         selectedIndex = 1
         scrollOffset = 0
     end
     if selectedIndex > scrollOffset + maxVisibleItems then
         scrollOffset = selectedIndex - maxVisibleItems
     end
+    trimCaches()
 end
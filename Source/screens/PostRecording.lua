@@ -199,11 +199,24 @@ function PostRecording:AButtonDown()
     local item = menuItems[selectedIndex]
     if not item or not note then return end
 
+    -- Coming from NotesList this is an index entry; processing needs the
+    -- transcript, so load the full note
+    if item.id ~= "view" and item.id ~= "delete" and not note.transcript then
+        note = NotesStore.get(note) or note
+        App.currentNote = note
+    end
+
     if item.id == "view" then
         ScreenManager:switchTo("noteView", {
             note = note,
             viewMode = "transcript"
         })
+    elseif item.id ~= "delete" and NotesStore.hasMode(note, item.id) then
+        -- Already generated (modes come back together from the server)
+        ScreenManager:switchTo("noteView", {
+            note = note,
+            viewMode = item.id
+        })
     elseif item.id == "minutes" then
         ScreenManager:switchTo("processing", {
             mode = "minutes",
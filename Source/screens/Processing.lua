@@ -13,12 +13,14 @@ local isComplete = false
 local hasError = false
 local errorMessage = ""
 local resultText = ""
+local aiRequest = nil  -- Identifies the AI request whose result this screen still wants
+local handedOff = false  -- Streaming text moved the request over to NoteView
 
 -- Upload finalization state
 local uploadPhase = "waiting"  -- "waiting" | "finalizing" | "done"
 local chunksQueued = 0
 local sessionId = nil
-local backupWavData = nil
+local backupWavPath = nil
 
 local modeLabels = {
     transcribe = "Transcribing...",
@@ -40,7 +42,7 @@ function Processing:enter(data)
     uploadPhase = "waiting"
     chunksQueued = data and data.chunksQueued or 0
     sessionId = data and data.sessionId
-    backupWavData = data and data.wavData
+    backupWavPath = data and data.wavPath
 
     -- Animation timer
     animTimer = playdate.timer.new(80, function()
@@ -52,27 +54,30 @@ function Processing:enter(data)
     if mode == "finalize" then
         self:startFinalization()
     elseif mode == "transcribe" then
-        self:startTranscription(data.wavData)
+        self:startTranscription(data.wavPath)
     else
         self:startAIProcessing(data.transcript, mode)
     end
 end
 
 function Processing:leave()
+    if not handedOff then
+        aiRequest = nil  -- A server request can't be aborted; drop its late result
+    end
     if animTimer then
         animTimer:remove()
         animTimer = nil
     end
 end
 
-function Processing:startTranscription(wavData)
-    if not wavData then
+function Processing:startTranscription(wavPath)
+    if not wavPath then
         hasError = true
         errorMessage = "No audio data"
         return
     end
 
-    OpenAI.transcribe(wavData, function(text, err)
+    OpenAI.transcribe(wavPath, function(text, err)
         if err then
             hasError = true
             errorMessage = err
@@ -96,28 +101,87 @@ function Processing:startAIProcessing(transcript, processingMode)
         return
     end
 
-    OpenAI.process(transcript, processingMode, function(result, err)
+    local request = {}
+    aiRequest = request
+    handedOff = false
+    local note = App.currentNote
+
+    -- Update note with processed content ("minutes", "summary" and/or
+    -- "todos"; the server returns them all at once)
+    local function saveResults(result, results)
+        results = results or { [processingMode] = result }
+        if note then
+            NotesStore.update(note.id, results)
+            for field, text in pairs(results) do
+                note[field] = text
+            end
+        end
+    end
+
+    local function onResult(result, err, results)
+        if aiRequest ~= request then
+            return
+        end
+        if handedOff then
+            -- NoteView is showing the streamed text; just keep the result
+            aiRequest = nil
+            if err then
+                print("Processing: Streamed " .. processingMode .. " failed: " .. err)
+            else
+                saveResults(result, results)
+            end
+            NoteView:finishStreaming(note, processingMode)
+            return
+        end
         if err then
             hasError = true
             errorMessage = err
         else
             isComplete = true
             resultText = result
-
-            -- Update note with processed content
-            if App.currentNote then
-                local updateField = processingMode  -- "minutes", "summary", or "todos"
-                NotesStore.update(App.currentNote.id, { [updateField] = result })
-                App.currentNote[updateField] = result
-            end
+            saveResults(result, results)
 
             -- Go to note view with processed content
             ScreenManager:switchTo("noteView", {
-                note = App.currentNote,
+                note = note,
                 viewMode = processingMode
             })
         end
-    end)
+    end
+
+    -- With a server, ask for every mode in one call (requested one first) so
+    -- picking the others later needs no request at all
+    local serverUrl = App.settings and App.settings.serverUrl
+    if serverUrl and serverUrl ~= "" and ChunkUploader.init({ serverUrl = serverUrl,
+                                                                 uploadSlots = App.settings.uploadSlots,
+                                                                 deviceId = App.settings.deviceId }) then
+        local actions = { processingMode }
+        for _, m in ipairs(OpenAI.getModes()) do
+            if m.id ~= processingMode then
+                table.insert(actions, m.id)
+            end
+        end
+        ChunkUploader.process(transcript, actions, onResult, function(newText, fullText)
+            if aiRequest ~= request then
+                return
+            end
+            if handedOff then
+                NoteView:streamText(note, processingMode, newText)
+            else
+                -- First text: show it in NoteView as it's written instead of
+                -- the spinner
+                handedOff = true
+                ScreenManager:switchTo("noteView", {
+                    note = note,
+                    viewMode = processingMode,
+                    streaming = true,
+                    text = fullText
+                })
+            end
+        end)
+    else
+        OpenAI.process(transcript, processingMode, onResult)
+    end
 end
 
 -- Start progressive upload finalization
@@ -153,13 +217,6 @@ function Processing:startFinalization()
     end)
 end
 
-function Processing:update()
-    -- Update chunk uploader (polls HTTP state) - critical for finalize mode
-    if mode == "finalize" then
-        ChunkUploader.update()
-    end
-end
-
 function Processing:draw()
     gfx.clear(gfx.kColorWhite)
 
@@ -316,11 +373,29 @@ function Processing:drawFooter()
 
     gfx.setFont(gfx.getSystemFont())
     local text = hasError and "B: Back" or "B: Cancel"
+    if self:canRetryFinalize() then
+        text = "A: Retry   B: Discard"
+    end
     local textWidth = gfx.getTextSize(text)
     gfx.drawText(text, (screenWidth - textWidth) / 2, y)
 end
 
+-- A finalize that failed with its upload session still open (chunks still
+-- on the spool) can be tried again
+function Processing:canRetryFinalize()
+    return hasError and mode == "finalize" and sessionId ~= nil
+        and ChunkUploader.getStatus().sessionId == sessionId
+end
+
 -- Input handlers
+function Processing:AButtonDown()
+    if self:canRetryFinalize() then
+        hasError = false
+        errorMessage = ""
+        self:startFinalization()
+    end
+end
+
 function Processing:BButtonDown()
     -- Cancel/back
     OpenAI.cancel()
@@ -15,8 +15,8 @@ local scrollOffset = 0
 local maxVisibleLines = 3
 local animFrame = 0
 local animTimer = nil
-local levelUpdateTimer = nil
 local currentLevel = 0
+local currentPeak = 0
 local reelAngle = 0
 
 -- Upload state
@@ -24,6 +24,19 @@ local uploadSessionId = nil
 local chunksQueued = 0
 local uploadEnabled = false
 
+-- Dirty-rect drawing: the static deck is drawn once, then each part is only
+-- redrawn when what it shows changes. Reels and meter are blitted from image
+-- tables rendered once.
+local REEL_RADIUS <const> = 22
+local REEL_STEP <const> = 8          -- Degrees the reels turn per animation tick
+local REEL_FRAMES <const> = 15       -- 3 spokes repeat every 120 degrees
+local VU_SEGMENTS <const> = 12
+local reelFrames = nil               -- Image table: reel at each step
+local vuFrames = nil                 -- Image table: meter with 0..VU_SEGMENTS lit
+local fullRedraw = true
+local drawn = {}                     -- What each part last showed
+local transcriptVersion = 0          -- Bumped whenever transcriptLines change
+
 -- Screen lifecycle
 function Recording:enter(data)
     isRecording = false
@@ -34,13 +47,18 @@ function Recording:enter(data)
     transcriptLines = {}
     scrollOffset = 0
     currentLevel = 0
+    currentPeak = 0
     animFrame = 0
     reelAngle = 0
     chunksQueued = 0
+    transcriptVersion = 0
+    fullRedraw = true
+    self:buildImages()
 
     -- Initialize uploader with settings
     if App.settings and App.settings.serverUrl and App.settings.serverUrl ~= "" then
-        ChunkUploader.init({ serverUrl = App.settings.serverUrl })
+        ChunkUploader.init({ serverUrl = App.settings.serverUrl, uploadSlots = App.settings.uploadSlots,
+                             deviceId = App.settings.deviceId })
         uploadEnabled = ChunkUploader.isEnabled()
     else
         uploadEnabled = false
@@ -57,14 +75,6 @@ function Recording:enter(data)
         end
     end)
     animTimer.repeats = true
-
-    -- Level meter update
-    levelUpdateTimer = playdate.timer.new(50, function()
-        if isRecording and not isPaused then
-            currentLevel = AudioRecorder.getLevel()
-        end
-    end)
-    levelUpdateTimer.repeats = true
 end
 
 function Recording:leave()
@@ -74,20 +84,21 @@ function Recording:leave()
 
     -- Don't cancel uploads here - we need them for Processing screen
     -- ChunkUploader.cancel() is called if user cancels from Processing screen
+    ChunkUploader.onPartial(nil)
 
     if animTimer then
         animTimer:remove()
         animTimer = nil
     end
-
-    if levelUpdateTimer then
-        levelUpdateTimer:remove()
-        levelUpdateTimer = nil
-    end
 end
 
 function Recording:startRecording()
-    local success, err = AudioRecorder.start()
+    AudioRecorder.setSampleRate(App.settings and App.settings.sampleRate or 8000)
+    AudioRecorder.setCodec(App.settings and App.settings.codec or "mulaw")
+    AudioRecorder.setChunkDuration(App.settings and App.settings.chunkDuration or 10,
+                                   App.settings and App.settings.chunkOverlapMs or 200)
+
+    local success, err = AudioRecorder.start(uploadEnabled)  -- Spool chunks on disk for upload
     if success then
         isRecording = true
         isPaused = false
@@ -95,8 +106,14 @@ function Recording:startRecording()
 
         -- Start upload session if enabled
         if uploadEnabled then
-            uploadSessionId = ChunkUploader.startSession()
+            uploadSessionId = ChunkUploader.startSession(AudioRecorder.getSampleRate(), AudioRecorder.getCodec())
             print("Upload session started: " .. tostring(uploadSessionId))
+
+            -- Show text as the server transcribes chunks
+            ChunkUploader.onPartial(function(newText, fullText)
+                liveTranscript = fullText
+                self:wrapTranscript()
+            end)
         end
     else
         print("Recording error: " .. tostring(err))
@@ -107,23 +124,15 @@ end
 function Recording:stopRecording()
     if not isRecording then return end
 
-    local wavData, duration = AudioRecorder.stop()
+    local wavPath, duration = AudioRecorder.stop()
     isRecording = false
 
-    -- Check for final chunk generated by stopRecording
-    if AudioRecorder.hasChunk() then
-        local chunkData = AudioRecorder.getChunk()
-        if chunkData and uploadEnabled and uploadSessionId then
-            local chunkSeq = AudioRecorder.getChunkSequence()
-            ChunkUploader.queueChunk(chunkData, chunkSeq)
-            chunksQueued = chunksQueued + 1
-            print("Chunk " .. chunkSeq .. " queued (" .. #chunkData .. " bytes)")
-        end
-    end
+    -- Drain any chunks still pending, including the final one from stopRecording
+    self:queueSpooledChunks()
 
-    if wavData then
+    if wavPath then
         App.currentNote = {
-            wavData = wavData,
+            wavPath = wavPath,
             duration = duration or elapsedSeconds,
             transcript = liveTranscript,
         }
@@ -133,14 +142,14 @@ function Recording:stopRecording()
             ScreenManager:switchTo("processing", {
                 mode = "finalize",  -- Finalize the upload session
                 sessionId = uploadSessionId,
-                wavData = wavData,  -- Keep WAV as backup
+                wavPath = wavPath,  -- Keep WAV as backup
                 chunksQueued = chunksQueued,
             })
         else
             -- Fallback to old mock flow
             ScreenManager:switchTo("processing", {
                 mode = "transcribe",
-                wavData = wavData,
+                wavPath = wavPath,
             })
         end
     else
@@ -153,24 +162,17 @@ function Recording:update()
         elapsedSeconds = (playdate.getCurrentTimeMilliseconds() - recordingStartTime) / 1000
     end
 
-    -- Update chunk uploader (polls HTTP state)
-    if uploadEnabled then
-        ChunkUploader.update()
+    -- Write pending backup audio to disk and read levels and chunk progress
+    -- (one call into C per frame)
+    local status = isRecording and AudioRecorder.poll()
+    if status and not isPaused then
+        currentLevel, currentPeak = status.level, status.peak
     end
 
-    -- Check for completed chunks and queue for upload
-    if isRecording and AudioRecorder.hasChunk() then
-        local chunkData = AudioRecorder.getChunk()
-        if chunkData then
-            local chunkSeq = AudioRecorder.getChunkSequence()
-
-            -- Queue for progressive upload
-            if uploadEnabled and uploadSessionId then
-                ChunkUploader.queueChunk(chunkData, chunkSeq)
-                chunksQueued = chunksQueued + 1
-                print("Chunk " .. chunkSeq .. " queued for upload (" .. #chunkData .. " bytes)")
-            end
-        end
+    -- Check for completed chunks and queue for upload (main.lua's
+    -- ChunkUploader.update starts them this frame)
+    if status then
+        self:queueSpooledChunks(status.sequence)
     end
 
     -- Handle crank for transcript scrolling
@@ -182,6 +184,19 @@ function Recording:update()
     end
 end
 
+-- Queue chunks that have reached the spool since last time for progressive upload
+-- (spooled defaults to asking the recorder, e.g. after the final chunk at stop)
+function Recording:queueSpooledChunks(spooled)
+    if not (uploadEnabled and uploadSessionId) then return end
+
+    spooled = spooled or AudioRecorder.getSpooledSequence()
+    while chunksQueued < spooled do
+        chunksQueued = chunksQueued + 1
+        ChunkUploader.queueChunk(chunksQueued)
+        print("Chunk " .. chunksQueued .. " queued for upload")
+    end
+end
+
 function Recording:wrapTranscript()
     transcriptLines = {}
     local maxWidth = 360
@@ -214,22 +229,57 @@ function Recording:wrapTranscript()
 
     local maxScroll = math.max(0, #transcriptLines - maxVisibleLines)
     scrollOffset = maxScroll
+    transcriptVersion = transcriptVersion + 1
+end
+
+-- Render the reel and meter image tables (once; they don't change)
+function Recording:buildImages()
+    if reelFrames then return end
+
+    local size = REEL_RADIUS * 2 + 4
+    reelFrames = gfx.imagetable.new(REEL_FRAMES)
+    for i = 1, REEL_FRAMES do
+        local image = gfx.image.new(size, size, gfx.kColorClear)
+        gfx.pushContext(image)
+        -- White disc under the spokes so the last frame's are covered,
+        -- transparent outside so the tape lines beside the reel survive
+        gfx.setColor(gfx.kColorWhite)
+        gfx.fillCircleAtPoint(size / 2, size / 2, REEL_RADIUS - 1)
+        reelAngle = (i - 1) * REEL_STEP
+        self:drawReel(size / 2, size / 2, REEL_RADIUS)
+        gfx.popContext()
+        reelFrames:setImage(i, image)
+    end
+    reelAngle = 0
+
+    vuFrames = gfx.imagetable.new(VU_SEGMENTS + 1)
+    for lit = 0, VU_SEGMENTS do
+        local image = gfx.image.new(122, 22, gfx.kColorWhite)
+        gfx.pushContext(image)
+        self:drawVUMeter(1, 1, 120, 20, lit)
+        gfx.popContext()
+        vuFrames:setImage(lit + 1, image)
+    end
 end
 
 function Recording:draw()
-    gfx.clear(gfx.kColorWhite)
+    if fullRedraw then
+        gfx.clear(gfx.kColorWhite)
+        self:drawStatic()
+        self:drawFooter()
+        drawn = {}
+        fullRedraw = false
+    end
 
     -- Draw cassette tape deck
     self:drawTapeDeck()
 
     -- Draw transcript area
     self:drawTranscript()
-
-    -- Draw footer
-    self:drawFooter()
 end
 
-function Recording:drawTapeDeck()
+-- Parts of the deck that never change
+function Recording:drawStatic()
     local screenWidth = 400
 
     -- Main cassette body
@@ -241,10 +291,6 @@ function Recording:drawTapeDeck()
     gfx.setLineWidth(2)
     gfx.drawRoundRect(30, 25, screenWidth - 60, 55, 4)
 
-    -- Draw spinning reels
-    self:drawReel(90, 52, 22)
-    self:drawReel(310, 52, 22)
-
     -- Tape between reels
     gfx.setLineWidth(1)
     gfx.drawLine(112, 52, 288, 52)
@@ -253,53 +299,92 @@ function Recording:drawTapeDeck()
     -- Recording head area
     gfx.fillRect(185, 65, 30, 12)
 
-    -- REC indicator with pulse
+    -- Transcript divider
+    gfx.drawLine(15, 115, screenWidth - 15, 115)
+end
+
+-- The deck's moving parts, each redrawn only when it changed
+function Recording:drawTapeDeck()
+    local screenWidth = 400
+
+    -- Spinning reels
+    local reelFrame = (reelAngle // REEL_STEP) % REEL_FRAMES + 1
+    if drawn.reel ~= reelFrame then
+        local image = reelFrames:getImage(reelFrame)
+        local offset = REEL_RADIUS + 2
+        image:draw(90 - offset, 52 - offset)
+        image:draw(310 - offset, 52 - offset)
+        drawn.reel = reelFrame
+    end
+
+    -- REC indicator with pulse, and upload indicator (if enabled)
     local recX = 25
     local recY = 85
-    if isRecording and not isPaused then
-        if animFrame < 15 then
+    local pulse = isRecording and not isPaused and animFrame < 15
+    local status = uploadEnabled and ChunkUploader.getStatus()
+    local uploadBlink = status and status.isUploading and animFrame < 10
+    local statusKey = table.concat({ tostring(pulse), tostring(isPaused),
+                                     status and status.uploadedChunks or "", tostring(uploadBlink) }, "|")
+    if drawn.status ~= statusKey then
+        -- Clipped short of the VU meter
+        gfx.setClipRect(recX - 5, recY - 1, 114, 20)
+        gfx.setColor(gfx.kColorWhite)
+        gfx.fillRect(recX - 5, recY - 1, 114, 20)
+        gfx.setColor(gfx.kColorBlack)
+        gfx.setLineWidth(1)
+        if pulse then
             gfx.fillCircleAtPoint(recX + 8, recY + 8, 6)
         else
             gfx.drawCircleAtPoint(recX + 8, recY + 8, 6)
         end
-    else
-        gfx.drawCircleAtPoint(recX + 8, recY + 8, 6)
-    end
 
-    gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
-    local statusText = isPaused and "PAUSE" or "REC"
-    gfx.drawText(statusText, recX + 20, recY + 1)
-
-    -- Upload indicator (if enabled)
-    if uploadEnabled then
-        local uploadX = recX + 70
-        local status = ChunkUploader.getStatus()
-        local uploadText = string.format("TX:%d", status.uploadedChunks)
-        if status.isUploading then
-            -- Blinking upload indicator
-            if animFrame < 10 then
+        gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
+        local statusText = isPaused and "PAUSE" or "REC"
+        gfx.drawText(statusText, recX + 20, recY + 1)
+
+        if status then
+            local uploadX = recX + 70
+            local uploadText = string.format("TX:%d", status.uploadedChunks)
+            if uploadBlink then
+                -- Blinking upload indicator
                 gfx.fillCircleAtPoint(uploadX, recY + 8, 4)
             end
+            gfx.drawText(uploadText, uploadX + 8, recY + 1)
         end
-        gfx.drawText(uploadText, uploadX + 8, recY + 1)
+        gfx.clearClipRect()
+        drawn.status = statusKey
     end
 
     -- Timer display (digital clock style)
     local minutes = math.floor(elapsedSeconds / 60)
     local seconds = math.floor(elapsedSeconds % 60)
     local timeText = string.format("%02d:%02d", minutes, seconds)
+    if drawn.time ~= timeText then
+        -- Timer box (the fill covers the previous time)
+        local timerX = screenWidth - 100
+        gfx.setColor(gfx.kColorBlack)
+        gfx.fillRoundRect(timerX, 82, 75, 22, 4)
+        gfx.setImageDrawMode(gfx.kDrawModeInverted)
+        gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
+        local timeWidth = gfx.getTextSize(timeText)
+        gfx.drawText(timeText, timerX + (75 - timeWidth) / 2, 85)
+        gfx.setImageDrawMode(gfx.kDrawModeCopy)
+        drawn.time = timeText
+    end
 
-    -- Timer box
-    local timerX = screenWidth - 100
-    gfx.fillRoundRect(timerX, 82, 75, 22, 4)
-    gfx.setImageDrawMode(gfx.kDrawModeInverted)
-    gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
-    local timeWidth = gfx.getTextSize(timeText)
-    gfx.drawText(timeText, timerX + (75 - timeWidth) / 2, 85)
-    gfx.setImageDrawMode(gfx.kDrawModeCopy)
-
-    -- VU Meter
-    self:drawVUMeter(140, 82, 120, 20)
+    -- VU Meter, with the held peak as a single lit segment past the bar
+    local lit = math.max(0, math.min(math.floor(currentLevel * VU_SEGMENTS), VU_SEGMENTS))
+    local peak = math.max(0, math.min(math.floor(currentPeak * VU_SEGMENTS), VU_SEGMENTS))
+    local vuKey = lit * (VU_SEGMENTS + 1) + peak
+    if drawn.vu ~= vuKey then
+        vuFrames:getImage(lit + 1):draw(139, 81)
+        if peak > lit then
+            local segmentWidth = 110 / VU_SEGMENTS
+            gfx.setColor(gfx.kColorBlack)
+            gfx.fillRect(145 + (peak - 1) * segmentWidth, 86, segmentWidth - 2, 12)
+        end
+        drawn.vu = vuKey
+    end
 end
 
 function Recording:drawReel(cx, cy, radius)
@@ -329,15 +414,14 @@ function Recording:drawReel(cx, cy, radius)
     gfx.drawCircleAtPoint(cx, cy, radius - 6)
 end
 
-function Recording:drawVUMeter(x, y, width, height)
+function Recording:drawVUMeter(x, y, width, height, activeSegments)
     gfx.setColor(gfx.kColorBlack)
     gfx.setLineWidth(2)
     gfx.drawRect(x, y, width, height)
 
     -- VU meter segments
-    local numSegments = 12
+    local numSegments = VU_SEGMENTS
     local segmentWidth = (width - 10) / numSegments
-    local activeSegments = math.floor(currentLevel * numSegments)
 
     for i = 0, numSegments - 1 do
         local segX = x + 5 + i * segmentWidth
@@ -361,15 +445,23 @@ function Recording:drawTranscript()
     local startY = 120
     local lineHeight = 22
 
+    local dots = #transcriptLines == 0 and (animFrame // 5) % 4 or 0
+    local key = transcriptVersion .. "|" .. scrollOffset .. "|" .. dots
+    if drawn.transcript == key then
+        return
+    end
+    drawn.transcript = key
+
+    -- Clear between the divider and the footer
+    gfx.setColor(gfx.kColorWhite)
+    gfx.fillRect(15, 117, screenWidth - 24, 86)
     gfx.setColor(gfx.kColorBlack)
     gfx.setLineWidth(1)
-    gfx.drawLine(15, startY - 5, screenWidth - 15, startY - 5)
 
     gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
 
     if #transcriptLines == 0 then
-        local dots = string.rep(".", (animFrame // 5) % 4)
-        gfx.drawText("Listening" .. dots, 20, startY + 15)
+        gfx.drawText("Listening" .. string.rep(".", dots), 20, startY + 15)
     else
         for i = 1, maxVisibleLines do
             local lineIndex = scrollOffset + i
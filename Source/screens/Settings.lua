@@ -7,12 +7,14 @@ Settings = {}
 local settingsItems = {
     { id = "apiKey", label = "OpenAI API Key", type = "text" },
     { id = "micInput", label = "Mic Input", type = "toggle", options = { "internal", "headset" } },
+    { id = "captureStats", label = "Capture Stats", type = "action" },
 }
 
 local selectedIndex = 1
 local isFirstRun = false
 local isEditing = false
 local showSetupInstructions = false
+local showStats = false
 local editText = ""
 local keyboardChars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
 local charIndex = 1
@@ -22,6 +24,7 @@ function Settings:enter(data)
     selectedIndex = 1
     isFirstRun = data and data.firstRun or false
     isEditing = false
+    showStats = false
     editText = ""
     charIndex = 1
 
@@ -77,7 +80,7 @@ function Settings:update()
                 charIndex = 1
             end
         end
-    elseif not showSetupInstructions then
+    elseif not showSetupInstructions and not showStats then
         local ticks = playdate.getCrankTicks(4)
         if ticks ~= 0 then
             selectedIndex = selectedIndex + ticks
@@ -95,6 +98,8 @@ function Settings:draw()
 
     if showSetupInstructions then
         self:drawSetupInstructions()
+    elseif showStats then
+        self:drawStatsOverlay()
     elseif isEditing then
         self:drawKeyboardMode()
     else
@@ -175,8 +180,8 @@ function Settings:drawSettingsMode()
     gfx.setImageDrawMode(gfx.kDrawModeCopy)
 
     -- Settings items
-    local startY = 50
-    local itemHeight = 70
+    local startY = 48
+    local itemHeight = 52
 
     for i, item in ipairs(settingsItems) do
         local y = startY + (i - 1) * itemHeight
@@ -187,7 +192,7 @@ function Settings:drawSettingsMode()
         gfx.drawText(item.label, 20, y)
 
         -- Value box
-        local valueY = y + 25
+        local valueY = y + 20
         local valueWidth = screenWidth - 50
         local valueHeight = 28
 
@@ -213,6 +218,8 @@ function Settings:drawSettingsMode()
         elseif item.type == "toggle" then
             local current = App.settings[item.id] or item.options[1]
             value = "< " .. current .. " >"
+        elseif item.type == "action" then
+            value = "Show >"
         end
 
         gfx.drawText(value, 30, valueY + 6)
@@ -230,6 +237,59 @@ function Settings:drawSettingsMode()
     gfx.drawText(footerText, (screenWidth - footerWidth) / 2, screenHeight - 25)
 end
 
+-- Debug overlay: capture pipeline counters from the last (or current) recording
+function Settings:drawStatsOverlay()
+    local screenWidth = 400
+    local screenHeight = 240
+    local stats = AudioRecorder.getStats()
+    local poolKB, poolUsedKB = AudioRecorder.getPoolSize()
+
+    -- Header
+    gfx.setColor(gfx.kColorBlack)
+    gfx.fillRoundRect(15, 8, screenWidth - 30, 32, 6)
+
+    gfx.setImageDrawMode(gfx.kDrawModeInverted)
+    if Fonts.asheville then
+        gfx.setFont(Fonts.asheville)
+    else
+        gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
+    end
+    gfx.drawText("CAPTURE STATS", (screenWidth - gfx.getTextSize("CAPTURE STATS")) / 2, 15)
+    gfx.setImageDrawMode(gfx.kDrawModeCopy)
+
+    local rows = {
+        { "Callbacks", string.format("%d", stats.callbacks) },
+        { "Callback ms", string.format("%.2f avg  %.2f min  %.2f max", stats.callbackAvgUs / 1000,
+                                       stats.callbackMinUs / 1000, stats.callbackMaxUs / 1000) },
+        { "Chunks lost", string.format("%d  (%d frames, ring full)", stats.chunksLost, stats.framesLost) },
+        { "Out of memory", string.format("%d", stats.oomEvents) },
+        { "Backup dropped", string.format("%d samples", stats.backupDropped) },
+        { "VAD kept", string.format("%d%%  (%d of %d frames)", math.floor(stats.vadKeepRatio * 100 + 0.5),
+                                    stats.framesKept, stats.framesKept + stats.framesDropped) },
+        { "Bytes", string.format("mulaw %d  adpcm %d", stats.mulawBytes, stats.adpcmBytes) },
+        { "Capture pool", string.format("%d of %d KB", poolUsedKB, poolKB) },
+    }
+
+    local y = 48
+    for _, row in ipairs(rows) do
+        gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
+        gfx.drawText(row[1], 20, y)
+        gfx.setFont(gfx.getSystemFont())
+        gfx.drawText(row[2], 140, y)
+        y = y + 19
+    end
+
+    -- Footer
+    gfx.setColor(gfx.kColorBlack)
+    gfx.setLineWidth(1)
+    gfx.drawLine(15, screenHeight - 35, screenWidth - 15, screenHeight - 35)
+
+    gfx.setFont(gfx.getSystemFont(gfx.kFontBold))
+    local footerText = "B: Back"
+    local footerWidth = gfx.getTextSize(footerText)
+    gfx.drawText(footerText, (screenWidth - footerWidth) / 2, screenHeight - 25)
+end
+
 function Settings:drawKeyboardMode()
     local screenWidth = 400
     local screenHeight = 240
@@ -322,6 +382,8 @@ function Settings:AButtonDown()
     if showSetupInstructions then
         -- Check again for api_key.txt
         self:checkForApiKey()
+    elseif showStats then
+        showStats = false
     elseif isEditing then
         local char = string.sub(keyboardChars, charIndex, charIndex)
         editText = editText .. char
@@ -329,6 +391,8 @@ function Settings:AButtonDown()
         local item = settingsItems[selectedIndex]
         if item.type == "text" then
             self:startEditing()
+        elseif item.type == "action" then
+            showStats = true
         elseif item.type == "toggle" then
             local current = App.settings[item.id] or item.options[1]
             local currentIdx = 1
@@ -354,6 +418,8 @@ function Settings:BButtonDown()
         showSetupInstructions = false
         selectedIndex = 1
         self:startEditing()
+    elseif showStats then
+        showStats = false
     elseif isEditing then
         self:stopEditing(true)
         if isFirstRun and App.settings.apiKey and #App.settings.apiKey > 0 then
@@ -379,7 +445,7 @@ function Settings:leftButtonDown()
 end
 
 function Settings:rightButtonDown()
-    if not isEditing and not showSetupInstructions then
+    if not isEditing and not showSetupInstructions and not showStats then
         local item = settingsItems[selectedIndex]
         if item.type == "toggle" then
             self:AButtonDown()
@@ -388,7 +454,7 @@ function Settings:rightButtonDown()
 end
 
 function Settings:upButtonDown()
-    if not isEditing and not showSetupInstructions then
+    if not isEditing and not showSetupInstructions and not showStats then
         selectedIndex = selectedIndex - 1
         if selectedIndex < 1 then
             selectedIndex = #settingsItems
@@ -397,7 +463,7 @@ function Settings:upButtonDown()
 end
 
 function Settings:downButtonDown()
-    if not isEditing and not showSetupInstructions then
+    if not isEditing and not showSetupInstructions and not showStats then
         selectedIndex = selectedIndex + 1
         if selectedIndex > #settingsItems then
             selectedIndex = 1
@@ -0,0 +1,472 @@
+/*
+ * CrankScribe DSP benchmark (host build: `make bench` in extension/)
+ *
+ * Feeds 44.1kHz 16-bit WAV files (or a built-in synthetic corpus when none are
+ * given) through the DSP core the way micCallback does, then reports:
+ *   - throughput of each stage in samples/sec (resampler counts input
+ *     samples; VAD and encoders count output samples)
+ *   - compression ratio per codec and VAD keep ratio
+ *   - golden-output hashes of each stage, compared against a golden file
+ *
+ * Usage: dsp_bench [--rate 8000|16000] [--golden FILE] [--update] [file.wav ...]
+ * Exits 1 if any hash differs from the golden file (--update rewrites the
+ * entries for the corpora and rates that were run, keeping the rest).
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "dsp_core.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define MIN_BENCH_SECONDS 0.2        // Repeat each stage until it has run this long
+#define MAX_CORPORA 64
+#define GOLDEN_LINE_MAX 256
+
+typedef struct {
+    char name[128];
+    int16_t* input;                  // 44.1kHz samples
+    size_t input_count;
+} Corpus;
+
+typedef struct {
+    uint64_t resample_hash;
+    uint64_t vad_hash;
+    uint64_t mulaw_hash;
+    uint64_t adpcm_hash;
+    size_t output_count;             // Samples at the output rate
+    size_t kept_count;               // Samples in frames the VAD kept
+    size_t frames;
+    size_t frames_kept;
+    double signal_energy;            // Kept samples, for the μ-law SNR
+    double mulaw_noise_energy;       // (decoded - original)² over kept samples
+} Result;
+
+static Resampler resampler;
+static VadState vad;
+
+// 64-bit FNV-1a over a byte stream
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ============================================================================
+// Corpora
+// ============================================================================
+
+static uint32_t read_u32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t read_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+// Load a 16-bit PCM WAV at 44.1kHz (first channel only); returns 0 on failure
+static int load_wav(const char* path, Corpus* corpus) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t* bytes = (uint8_t*)malloc((size_t)size);
+    if (!bytes || fread(bytes, 1, (size_t)size, file) != (size_t)size) {
+        fprintf(stderr, "%s: read failed\n", path);
+        fclose(file);
+        free(bytes);
+        return 0;
+    }
+    fclose(file);
+
+    int ok = 0;
+    int channels = 0, rate = 0, bits = 0;
+    if (size >= 12 && !memcmp(bytes, "RIFF", 4) && !memcmp(bytes + 8, "WAVE", 4)) {
+        long pos = 12;
+        while (pos + 8 <= size) {
+            uint32_t chunk_size = read_u32(bytes + pos + 4);
+            const uint8_t* body = bytes + pos + 8;
+            if (!memcmp(bytes + pos, "fmt ", 4) && chunk_size >= 16) {
+                channels = read_u16(body + 2);
+                rate = (int)read_u32(body + 4);
+                bits = read_u16(body + 14);
+            } else if (!memcmp(bytes + pos, "data", 4)) {
+                if (read_u16(bytes + 20) != 1 || bits != 16 || rate != DSP_INPUT_RATE || channels < 1) {
+                    fprintf(stderr, "%s: need 16-bit PCM at %d Hz (got %d-bit, %d Hz)\n",
+                            path, DSP_INPUT_RATE, bits, rate);
+                    break;
+                }
+                if (chunk_size > (uint32_t)(size - (pos + 8))) {
+                    chunk_size = (uint32_t)(size - (pos + 8));
+                }
+                corpus->input_count = chunk_size / (2 * (size_t)channels);
+                corpus->input = (int16_t*)malloc(corpus->input_count * sizeof(int16_t));
+                for (size_t i = 0; i < corpus->input_count; i++) {
+                    corpus->input[i] = (int16_t)read_u16(body + i * 2 * (size_t)channels);
+                }
+                ok = 1;
+                break;
+            }
+            pos += 8 + chunk_size + (chunk_size & 1);
+        }
+    } else {
+        fprintf(stderr, "%s: not a WAV file\n", path);
+    }
+    free(bytes);
+
+    const char* base = strrchr(path, '/');
+    snprintf(corpus->name, sizeof(corpus->name), "%s", base ? base + 1 : path);
+    return ok;
+}
+
+// sin() from + and * only, so the synthetic corpus is bit-identical whatever
+// the host's libm (golden hashes still depend on the resampler's coefficient
+// build using sinf/lrintf, which is the device code)
+static double synth_sin(double x) {
+    double turns = x / (2.0 * M_PI);
+    x = (turns - floor(turns + 0.5)) * 2.0 * M_PI;  // -pi..pi
+    double x2 = x * x;
+    return x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0 * (1.0 - x2 / 42.0 * (1.0 - x2 / 72.0 * (1.0 - x2 / 110.0 * (1.0 - x2 / 156.0))))));
+}
+
+// Deterministic 30s stand-in for a recording: room noise with bursts of
+// voiced-like harmonics every few seconds, a keyboard-like noise burst, and a
+// clipped shout, so every VAD path and the encoders' extremes are exercised
+static void make_synthetic(Corpus* corpus) {
+    size_t count = (size_t)DSP_INPUT_RATE * 30;
+    corpus->input = (int16_t*)malloc(count * sizeof(int16_t));
+    corpus->input_count = count;
+    snprintf(corpus->name, sizeof(corpus->name), "synthetic");
+
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double noise = (double)(int32_t)(seed >> 16 & 0xFFFF) / 65536.0 - 0.5;
+        double t = (double)i / DSP_INPUT_RATE;
+        int second = (int)t;
+        double value = noise * 200.0;
+
+        if (second % 4 == 1 || second % 4 == 2) {
+            // Voiced: 140Hz fundamental with falling harmonics, syllable envelope
+            double envelope = 0.5 - 0.5 * synth_sin(2.0 * M_PI * t * 3.0 + M_PI / 2.0);
+            double voice = 0.0;
+            for (int h = 1; h <= 8; h++) {
+                voice += synth_sin(2.0 * M_PI * 140.0 * h * t) / h;
+            }
+            value += voice * 6000.0 * envelope;
+        } else if (second == 11) {
+            value = noise * 12000.0;                      // Broadband burst (keyboard/HVAC)
+        } else if (second == 23) {
+            value += synth_sin(2.0 * M_PI * 300.0 * t) * 60000.0;  // Clipped shout
+        }
+
+        if (value > 32767.0) value = 32767.0;
+        if (value < -32768.0) value = -32768.0;
+        corpus->input[i] = (int16_t)floor(value + 0.5);
+    }
+}
+
+// ============================================================================
+// Pipeline
+// ============================================================================
+
+// Run the whole chain once (as micCallback does) for results and hashes
+static void run_chain(const Corpus* corpus, int rate, Result* result) {
+    static AdpcmState adpcm;
+    memset(result, 0, sizeof(*result));
+    result->resample_hash = result->vad_hash = result->mulaw_hash = result->adpcm_hash = FNV_OFFSET;
+
+    resampler_init(&resampler, rate);
+    vad_reset(&vad, rate / VAD_FRAMES_PER_SECOND);
+    adpcm_reset(&adpcm);
+    int pending = -1;
+
+    for (size_t offset = 0; offset < corpus->input_count; offset += RS_BLOCK) {
+        size_t remaining = corpus->input_count - offset;
+        int block = remaining < RS_BLOCK ? (int)remaining : RS_BLOCK;
+        int produced = resample_block(&resampler, corpus->input + offset, block);
+        result->resample_hash = fnv1a(result->resample_hash, resampler.output, (size_t)produced * sizeof(int16_t));
+        result->output_count += (size_t)produced;
+
+        for (int i = 0; i < produced; i++) {
+            if (!vad_accumulate(&vad, resampler.output[i])) continue;
+
+            uint8_t keep = (uint8_t)vad_decide(&vad);
+            result->vad_hash = fnv1a(result->vad_hash, &keep, 1);
+            result->frames++;
+            if (!keep) continue;
+
+            result->frames_kept++;
+            result->kept_count += (size_t)vad.frame_size;
+            uint8_t mu[VAD_FRAME_MAX];
+            mulaw_encode_block(vad.frame, mu, vad.frame_size);
+            result->mulaw_hash = fnv1a(result->mulaw_hash, mu, (size_t)vad.frame_size);
+            for (int k = 0; k < vad.frame_size; k++) {
+                double error = (double)mulaw_decode(mu[k]) - vad.frame[k];
+                result->signal_energy += (double)vad.frame[k] * vad.frame[k];
+                result->mulaw_noise_energy += error * error;
+
+                uint8_t code = adpcm_encode(&adpcm, vad.frame[k]);
+                if (pending < 0) {
+                    pending = code << 4;
+                } else {
+                    uint8_t packed = (uint8_t)(pending | code);
+                    result->adpcm_hash = fnv1a(result->adpcm_hash, &packed, 1);
+                    pending = -1;
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    const char* name;
+    double samples_per_second;
+} StageTiming;
+
+// Time each stage on its own: the resampler over the input, the VAD over the
+// resampled signal, and each encoder over the resampled signal
+static void time_stages(const Corpus* corpus, int rate, StageTiming timings[4]) {
+    size_t capacity = corpus->input_count * (size_t)rate / DSP_INPUT_RATE + RS_BLOCK;
+    int16_t* output = (int16_t*)malloc(capacity * sizeof(int16_t));
+    size_t output_count = 0;
+    volatile uint32_t sink = 0;      // Keeps the encoders' work observable
+    uint8_t encoded[RS_BLOCK];
+
+    resampler_init(&resampler, rate);
+    for (size_t offset = 0; offset < corpus->input_count; offset += RS_BLOCK) {
+        size_t remaining = corpus->input_count - offset;
+        int produced = resample_block(&resampler, corpus->input + offset,
+                                      remaining < RS_BLOCK ? (int)remaining : RS_BLOCK);
+        memcpy(output + output_count, resampler.output, (size_t)produced * sizeof(int16_t));
+        output_count += (size_t)produced;
+    }
+
+    for (int stage = 0; stage < 4; stage++) {
+        static const char* names[4] = { "resample", "vad", "mulaw", "adpcm" };
+        size_t samples = 0;
+        double start = now_seconds();
+        double elapsed = 0.0;
+        do {
+            if (stage == 0) {
+                resampler_init(&resampler, rate);
+                for (size_t offset = 0; offset < corpus->input_count; offset += RS_BLOCK) {
+                    size_t remaining = corpus->input_count - offset;
+                    resample_block(&resampler, corpus->input + offset, remaining < RS_BLOCK ? (int)remaining : RS_BLOCK);
+                }
+                samples += corpus->input_count;
+            } else if (stage == 1) {
+                vad_reset(&vad, rate / VAD_FRAMES_PER_SECOND);
+                for (size_t i = 0; i < output_count; i++) {
+                    if (vad_accumulate(&vad, output[i])) {
+                        sink += (uint32_t)vad_decide(&vad);
+                    }
+                }
+                samples += output_count;
+            } else if (stage == 2) {
+                for (size_t i = 0; i < output_count; i += RS_BLOCK) {
+                    int block = output_count - i < RS_BLOCK ? (int)(output_count - i) : RS_BLOCK;
+                    mulaw_encode_block(output + i, encoded, block);
+                    sink += encoded[0];
+                }
+                samples += output_count;
+            } else {
+                AdpcmState adpcm;
+                adpcm_reset(&adpcm);
+                for (size_t i = 0; i < output_count; i++) {
+                    sink += adpcm_encode(&adpcm, output[i]);
+                }
+                samples += output_count;
+            }
+            elapsed = now_seconds() - start;
+        } while (elapsed < MIN_BENCH_SECONDS);
+
+        timings[stage].name = names[stage];
+        timings[stage].samples_per_second = (double)samples / elapsed;
+    }
+
+    (void)sink;
+    free(output);
+}
+
+// ============================================================================
+// Golden file: one line per corpus and rate with the four stage hashes
+// ============================================================================
+
+static int golden_lookup(const char* path, const char* name, int rate, Result* golden) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    char line[GOLDEN_LINE_MAX];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        char entry[128];
+        int entry_rate;
+        unsigned long long h[4];
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %d %llx %llx %llx %llx", entry, &entry_rate, &h[0], &h[1], &h[2], &h[3]) == 6 &&
+            !strcmp(entry, name) && entry_rate == rate) {
+            golden->resample_hash = h[0];
+            golden->vad_hash = h[1];
+            golden->mulaw_hash = h[2];
+            golden->adpcm_hash = h[3];
+            found = 1;
+        }
+    }
+    fclose(file);
+    return found;
+}
+
+static void golden_write_line(FILE* file, const char* name, int rate, const Result* result) {
+    fprintf(file, "%s %d %016llx %016llx %016llx %016llx\n", name, rate,
+            (unsigned long long)result->resample_hash, (unsigned long long)result->vad_hash,
+            (unsigned long long)result->mulaw_hash, (unsigned long long)result->adpcm_hash);
+}
+
+// Open the golden file for --update: entries for corpora/rates not being run
+// are carried over, the rest are appended as they are measured
+static int golden_rewrite_begin(const char* path, const Corpus* corpora, int corpus_count,
+                                const int* rates, int rate_count, FILE** out) {
+    char* kept = NULL;
+    size_t kept_size = 0;
+    FILE* file = fopen(path, "r");
+    if (file) {
+        char line[GOLDEN_LINE_MAX];
+        while (fgets(line, sizeof(line), file)) {
+            char entry[128];
+            int entry_rate;
+            if (line[0] == '#' || sscanf(line, "%127s %d", entry, &entry_rate) != 2) continue;
+            int replaced = 0;
+            for (int c = 0; c < corpus_count; c++) {
+                for (int r = 0; r < rate_count; r++) {
+                    replaced |= !strcmp(entry, corpora[c].name) && entry_rate == rates[r];
+                }
+            }
+            if (replaced) continue;
+            size_t length = strlen(line);
+            kept = (char*)realloc(kept, kept_size + length + 1);
+            memcpy(kept + kept_size, line, length + 1);
+            kept_size += length;
+        }
+        fclose(file);
+    }
+
+    *out = fopen(path, "w");
+    if (*out) {
+        fprintf(*out, "# corpus rate resample vad mulaw adpcm (FNV-1a 64 of each stage's output)\n");
+        if (kept) fputs(kept, *out);
+    }
+    free(kept);
+    return *out != NULL;
+}
+
+int main(int argc, char** argv) {
+    int rates[2] = { 8000, 16000 };
+    int rate_count = 2;
+    const char* golden_path = NULL;
+    int update = 0;
+    Corpus corpora[MAX_CORPORA];
+    int corpus_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--rate") && i + 1 < argc) {
+            rates[0] = atoi(argv[++i]);
+            rate_count = 1;
+            if (rates[0] != 8000 && rates[0] != 16000) {
+                fprintf(stderr, "--rate must be 8000 or 16000\n");
+                return 2;
+            }
+        } else if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+            golden_path = argv[++i];
+        } else if (!strcmp(argv[i], "--update")) {
+            update = 1;
+        } else if (corpus_count < MAX_CORPORA) {
+            if (!load_wav(argv[i], &corpora[corpus_count])) return 2;
+            corpus_count++;
+        }
+    }
+    if (corpus_count == 0) {
+        make_synthetic(&corpora[corpus_count++]);
+    }
+
+    FILE* golden_out = NULL;
+    if (update && golden_path) {
+        if (!golden_rewrite_begin(golden_path, corpora, corpus_count, rates, rate_count, &golden_out)) {
+            fprintf(stderr, "%s: cannot write\n", golden_path);
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    for (int c = 0; c < corpus_count; c++) {
+        const Corpus* corpus = &corpora[c];
+        for (int r = 0; r < rate_count; r++) {
+            int rate = rates[r];
+            Result result;
+            StageTiming timings[4];
+            run_chain(corpus, rate, &result);
+            time_stages(corpus, rate, timings);
+
+            double seconds = (double)corpus->input_count / DSP_INPUT_RATE;
+            double raw_bytes = (double)corpus->input_count * 2.0;
+            double mulaw_bytes = (double)result.kept_count;
+            double adpcm_bytes = (double)((result.kept_count + 1) / 2);
+
+            printf("%s @ %d Hz (%.1fs of audio)\n", corpus->name, rate, seconds);
+            for (int s = 0; s < 4; s++) {
+                printf("  %-9s %12.0f samples/s  (%.0fx real time)\n", timings[s].name,
+                       timings[s].samples_per_second,
+                       timings[s].samples_per_second / (s == 0 ? DSP_INPUT_RATE : rate));
+            }
+            printf("  vad keep  %5.1f%%  (%zu of %zu frames)\n",
+                   result.frames ? 100.0 * result.frames_kept / result.frames : 0.0,
+                   result.frames_kept, result.frames);
+            printf("  mulaw     %zu bytes, %.1f%% of 44.1kHz 16-bit, SNR %.1f dB\n", (size_t)mulaw_bytes,
+                   100.0 * mulaw_bytes / raw_bytes,
+                   result.mulaw_noise_energy > 0 ? 10.0 * log10(result.signal_energy / result.mulaw_noise_energy) : 0.0);
+            printf("  adpcm     %zu bytes, %.1f%% of 44.1kHz 16-bit\n", (size_t)adpcm_bytes, 100.0 * adpcm_bytes / raw_bytes);
+
+            if (golden_out) {
+                golden_write_line(golden_out, corpus->name, rate, &result);
+                printf("  golden    updated\n");
+            } else if (golden_path) {
+                Result golden;
+                if (!golden_lookup(golden_path, corpus->name, rate, &golden)) {
+                    printf("  golden    no entry (run with --update to add)\n");
+                } else {
+                    const char* stages[4] = { "resample", "vad", "mulaw", "adpcm" };
+                    uint64_t got[4] = { result.resample_hash, result.vad_hash, result.mulaw_hash, result.adpcm_hash };
+                    uint64_t want[4] = { golden.resample_hash, golden.vad_hash, golden.mulaw_hash, golden.adpcm_hash };
+                    int ok = 1;
+                    for (int s = 0; s < 4; s++) {
+                        if (got[s] != want[s]) {
+                            printf("  golden    MISMATCH in %s output\n", stages[s]);
+                            ok = 0;
+                        }
+                    }
+                    if (ok) printf("  golden    ok\n");
+                    failures += !ok;
+                }
+            }
+        }
+        free(corpora[c].input);
+    }
+
+    if (golden_out) fclose(golden_out);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/*
+ * CrankScribe DSP core - see dsp_core.h
+ *
+ * Plain C99 with libm; builds for the device (with the Cortex-M7 DSP
+ * extension when available) and for the host benchmark.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "dsp_core.h"
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>               // __smlad on Cortex-M7
+#endif
+
+// VAD configuration
+#define VAD_SPEECH_RATIO 4           // Energy vs noise floor for possible speech (~6 dB)
+#define VAD_SPEECH_RATIO_STRONG 16   // Energy vs noise floor for certain speech (~12 dB)
+#define VAD_ZCR_MAX_HZ 3000          // Weak frames crossing zero faster than this are broadband noise
+#define VAD_NOISE_FLOOR_MIN 10000    // RMS 100 - quiet-room floor so hiss never counts as speech
+#define VAD_NOISE_FLOOR_INIT 140000  // RMS ~375 - roughly the old fixed threshold
+#define VAD_HOLDOVER_FRAMES 25       // Keep ~500ms after speech ends
+
+// Level meter (fed by the VAD's per-frame energy, no extra pass over the input)
+#define LEVEL_PEAK_HOLD_FRAMES 25     // Peak stays put ~500ms before decaying
+#define LEVEL_DECAY_SHIFT 3           // Per-frame release: level -= level / 8
+
+// Polyphase resampler configuration
+#define RS_KAISER_BETA 6.0f          // ~60 dB stopband attenuation
+#define RS_CUTOFF      0.42f         // Passband edge as a fraction of the output rate
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// μ-law Compression (ITU G.711 standard)
+// Reduces 16-bit samples to 8-bit with logarithmic compression
+// Optimized for speech - maintains quality while halving size
+// ============================================================================
+
+// Decode table: sign, 3-bit segment and 4-bit mantissa of the inverted code,
+// ((mantissa << 3) + bias) << segment, less the bias
+#define MULAW_DECODE(u) ((int16_t)((((0xFF ^ (u)) & 0x80) ? -1 : 1) * \
+    ((((((0xFF ^ (u)) & 0x0F) << 3) + MULAW_BIAS) << (((0xFF ^ (u)) >> 4) & 7)) - MULAW_BIAS)))
+#define MULAW_DECODE4(u)  MULAW_DECODE(u), MULAW_DECODE((u) + 1), MULAW_DECODE((u) + 2), MULAW_DECODE((u) + 3)
+#define MULAW_DECODE16(u) MULAW_DECODE4(u), MULAW_DECODE4((u) + 4), MULAW_DECODE4((u) + 8), MULAW_DECODE4((u) + 12)
+#define MULAW_DECODE64(u) MULAW_DECODE16(u), MULAW_DECODE16((u) + 16), MULAW_DECODE16((u) + 32), MULAW_DECODE16((u) + 48)
+
+const int16_t mulaw_decode_table[256] = {
+    MULAW_DECODE64(0), MULAW_DECODE64(64), MULAW_DECODE64(128), MULAW_DECODE64(192)
+};
+
+// Four independent samples per pass keep the M7's dual-issue pipeline busy
+// and cost one loop branch per four bytes
+void mulaw_encode_block(const int16_t* in, uint8_t* out, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8_t a = mulaw_encode(in[i]);
+        uint8_t b = mulaw_encode(in[i + 1]);
+        uint8_t c = mulaw_encode(in[i + 2]);
+        uint8_t d = mulaw_encode(in[i + 3]);
+        out[i] = a;
+        out[i + 1] = b;
+        out[i + 2] = c;
+        out[i + 3] = d;
+    }
+    for (; i < count; i++) {
+        out[i] = mulaw_encode(in[i]);
+    }
+}
+
+// ============================================================================
+// IMA-ADPCM Compression (Intel/DVI)
+// 4 bits/sample - half the size of μ-law. Chunk framing (nibble packing and
+// the per-chunk state header) is left to the caller.
+// ============================================================================
+
+static const int8_t adpcm_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int16_t adpcm_step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767
+};
+
+void adpcm_reset(AdpcmState* state) {
+    state->predictor = 0;
+    state->index = 0;
+}
+
+uint8_t adpcm_encode(AdpcmState* state, int16_t sample) {
+    int step = adpcm_step_table[state->index];
+    int diff = sample - state->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    int vpdiff = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    state->predictor += (code & 8) ? -vpdiff : vpdiff;
+    if (state->predictor > 32767) state->predictor = 32767;
+    if (state->predictor < -32768) state->predictor = -32768;
+
+    state->index += adpcm_index_table[code];
+    if (state->index < 0) state->index = 0;
+    if (state->index > 88) state->index = 88;
+
+    return code;
+}
+
+// ============================================================================
+// Voice Activity Detection (VAD)
+// Frame-synchronous detector to skip silence and reduce upload size.
+// Energy and zero crossings accumulate as samples arrive; one decision is made
+// per 20ms frame against an adaptive noise floor, and whole frames are kept
+// or dropped.
+// ============================================================================
+
+void vad_reset(VadState* vad, int frame_size) {
+    vad->frame_size = frame_size;
+    vad->frame_pos = 0;
+    vad->energy_sum = 0;
+    vad->zero_crossings = 0;
+    vad->last_sample = 0;
+    vad->frame_peak = 0;
+    vad->noise_floor = VAD_NOISE_FLOOR_INIT;
+    vad->holdover = 0;
+    vad->speech = 1;
+    vad->level_energy = 0;
+    vad->level_peak = 0;
+    vad->level_peak_hold = 0;
+}
+
+// Meter ballistics, once per frame: RMS energy and peak jump up at once and
+// fall back smoothly (the peak only after being held)
+static void level_update(VadState* vad, uint32_t energy, int32_t peak) {
+    if (energy >= vad->level_energy) {
+        vad->level_energy = energy;
+    } else {
+        vad->level_energy -= (vad->level_energy - energy) >> LEVEL_DECAY_SHIFT;
+    }
+
+    if (peak >= vad->level_peak) {
+        vad->level_peak = peak;
+        vad->level_peak_hold = LEVEL_PEAK_HOLD_FRAMES;
+    } else if (vad->level_peak_hold > 0) {
+        vad->level_peak_hold--;
+    } else {
+        vad->level_peak -= (vad->level_peak - peak + (1 << LEVEL_DECAY_SHIFT) - 1) >> LEVEL_DECAY_SHIFT;
+    }
+}
+
+uint32_t isqrt32(uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+int vad_decide(VadState* vad) {
+    uint32_t energy = (uint32_t)(vad->energy_sum / (uint64_t)vad->frame_size);
+    int zcr_hz = vad->zero_crossings * VAD_FRAMES_PER_SECOND;
+    uint64_t floor = vad->noise_floor;
+
+    // Loud frames are speech; moderately loud ones only if they aren't
+    // broadband noise (keyboard, HVAC) with a very high zero-crossing rate
+    int speech = (uint64_t)energy > floor * VAD_SPEECH_RATIO_STRONG ||
+                 ((uint64_t)energy > floor * VAD_SPEECH_RATIO && zcr_hz < VAD_ZCR_MAX_HZ);
+
+    // Track the noise floor: fall quickly, rise slowly (very slowly during speech)
+    if (energy < vad->noise_floor) {
+        vad->noise_floor -= (vad->noise_floor - energy) >> 3;
+    } else {
+        vad->noise_floor += (energy - vad->noise_floor) >> (speech ? 10 : 6);
+    }
+    if (vad->noise_floor < VAD_NOISE_FLOOR_MIN) {
+        vad->noise_floor = VAD_NOISE_FLOOR_MIN;
+    }
+
+    level_update(vad, energy, vad->frame_peak);
+
+    vad->frame_pos = 0;
+    vad->energy_sum = 0;
+    vad->zero_crossings = 0;
+    vad->frame_peak = 0;
+
+    if (speech) {
+        vad->holdover = VAD_HOLDOVER_FRAMES;  // Reset holdover when speech detected
+        vad->speech = 1;
+    } else if (vad->holdover > 0) {
+        // During holdover period, still output (prevents cutting off word endings)
+        vad->holdover--;
+        vad->speech = 1;
+    } else {
+        vad->speech = 0;  // Silence - skip this frame
+    }
+
+    return vad->speech;
+}
+
+// ============================================================================
+// Polyphase Resampler (Q15 fixed point)
+// 44.1kHz → 8kHz is L/M = 80/441 (16kHz is 160/441). A Kaiser-windowed sinc
+// prototype at L × 44.1kHz is split into L phases of RS_TAPS coefficients, so
+// each output sample is a single RS_TAPS-long dot product - two MACs per SMLAD
+// on device. Whole callback blocks are processed; no per-sample float math.
+// ============================================================================
+
+// Zeroth-order modified Bessel function (for the Kaiser window)
+static float bessel_i0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    float q = x * x * 0.25f;
+    for (int k = 1; k < 25; k++) {
+        term *= q / (float)(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void resampler_init(Resampler* rs, int out_rate) {
+    if (rs->rate != out_rate) {
+        int g = gcd(DSP_INPUT_RATE, out_rate);
+        int interp = out_rate / g;
+        int decim = DSP_INPUT_RATE / g;
+        int length = interp * RS_TAPS;
+
+        // Cutoff in cycles per sample at the upsampled rate
+        float fc = RS_CUTOFF * (float)out_rate / ((float)DSP_INPUT_RATE * (float)interp);
+        float center = (float)(length - 1) * 0.5f;
+        float i0_beta = bessel_i0(RS_KAISER_BETA);
+
+        for (int p = 0; p < interp; p++) {
+            float taps[RS_TAPS];
+            float sum = 0.0f;
+
+            for (int k = 0; k < RS_TAPS; k++) {
+                float t = (float)(k * interp + p) - center;
+                float sinc = (t == 0.0f) ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * t) / ((float)M_PI * t);
+                float w = t / center;
+                float window = bessel_i0(RS_KAISER_BETA * sqrtf(fmaxf(0.0f, 1.0f - w * w))) / i0_beta;
+                taps[k] = sinc * window;
+                sum += taps[k];
+            }
+
+            // Unity DC gain per phase; reversed so the dot product walks history forwards
+            for (int k = 0; k < RS_TAPS; k++) {
+                rs->coeffs[p * RS_TAPS + (RS_TAPS - 1 - k)] = (int16_t)lrintf(taps[k] / sum * 32767.0f);
+            }
+        }
+
+        rs->interp = interp;
+        rs->decim_step = decim / interp;
+        rs->phase_step = decim % interp;
+        rs->rate = out_rate;
+    }
+
+    memset(rs->buffer, 0, sizeof(rs->buffer));
+    rs->phase = 0;
+    rs->position = RS_TAPS - 1;
+}
+
+// Q15 dot product of RS_TAPS samples with one filter phase
+static inline int32_t resampler_dot(const int16_t* x, const int16_t* h) {
+    int32_t acc = 0;
+#if defined(__ARM_FEATURE_DSP)
+    for (int k = 0; k < RS_TAPS; k += 2) {
+        int32_t xp, hp;
+        memcpy(&xp, x + k, sizeof(xp));
+        memcpy(&hp, h + k, sizeof(hp));
+        acc = __smlad(xp, hp, acc);
+    }
+#else
+    for (int k = 0; k < RS_TAPS; k++) {
+        acc += (int32_t)x[k] * h[k];
+    }
+#endif
+    return acc;
+}
+
+int resample_block(Resampler* rs, const int16_t* in, int len) {
+    int produced = 0;
+    int end = RS_TAPS - 1 + len;
+
+    memcpy(rs->buffer + RS_TAPS - 1, in, len * sizeof(int16_t));
+
+    while (rs->position < end) {
+        int32_t acc = resampler_dot(rs->buffer + rs->position - (RS_TAPS - 1), rs->coeffs + rs->phase * RS_TAPS);
+        acc = (acc + (1 << 14)) >> 15;
+        if (acc > 32767) acc = 32767;
+        if (acc < -32768) acc = -32768;
+        rs->output[produced++] = (int16_t)acc;
+
+        rs->position += rs->decim_step;
+        rs->phase += rs->phase_step;
+        if (rs->phase >= rs->interp) {
+            rs->phase -= rs->interp;
+            rs->position++;
+        }
+    }
+
+    // Keep the last RS_TAPS - 1 inputs as history for the next block
+    memmove(rs->buffer, rs->buffer + len, (RS_TAPS - 1) * sizeof(int16_t));
+    rs->position -= len;
+
+    return produced;
+}
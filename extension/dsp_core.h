@@ -0,0 +1,155 @@
+/*
+ * CrankScribe DSP core
+ *
+ * The capture pipeline's signal processing with no Playdate API dependency:
+ * polyphase resampler, VAD (with the level meter it feeds), μ-law and
+ * IMA-ADPCM encoders. mic_capture.c drives it from the mic callback; the host
+ * benchmark (bench/dsp_bench.c) drives it from WAV files.
+ *
+ * Every stage keeps its state in a struct owned by the caller, and nothing
+ * here allocates.
+ */
+
+#ifndef DSP_CORE_H
+#define DSP_CORE_H
+
+#include <stdint.h>
+
+#define DSP_INPUT_RATE 44100         // Playdate native sample rate
+
+// ============================================================================
+// μ-law Compression (ITU G.711 standard)
+// The segment comes from a count-leading-zeros of the biased magnitude, so
+// encoding touches no table; decoding uses a 256-entry const table the
+// compiler builds (nothing to initialize at startup)
+// ============================================================================
+
+#define MULAW_BIAS 0x84
+#define MULAW_CLIP 32635
+
+#if defined(__GNUC__) || defined(__clang__)
+#define dsp_clz32(x) __builtin_clz(x)  // CLZ instruction on Cortex-M7
+#else
+static inline int dsp_clz32(uint32_t x) {
+    int n = 0;
+    while (!(x & 0x80000000u)) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+}
+#endif
+
+extern const int16_t mulaw_decode_table[256];
+
+// Encode single 16-bit sample to 8-bit μ-law
+static inline uint8_t mulaw_encode(int16_t sample) {
+    int32_t value = sample;
+    int sign = (value >> 8) & 0x80;
+    if (value < 0) value = -value;
+    if (value > MULAW_CLIP) value = MULAW_CLIP;
+    value += MULAW_BIAS;  // Leading one is now bit 7..14: segment 0..7
+
+    int exponent = 24 - dsp_clz32((uint32_t)value);
+    int mantissa = (value >> (exponent + 3)) & 0x0F;
+    return (uint8_t)~(sign | (exponent << 4) | mantissa);
+}
+
+// Encode count samples into out (four per iteration)
+void mulaw_encode_block(const int16_t* in, uint8_t* out, int count);
+
+// Decode one μ-law byte to a 16-bit sample
+static inline int16_t mulaw_decode(uint8_t code) {
+    return mulaw_decode_table[code];
+}
+
+// ============================================================================
+// IMA-ADPCM Compression (Intel/DVI)
+// ============================================================================
+
+typedef struct {
+    int predictor;                   // Last reconstructed sample
+    int index;                       // Step table index
+} AdpcmState;
+
+void adpcm_reset(AdpcmState* state);
+
+// Encode one 16-bit sample to a 4-bit ADPCM code (updates encoder state)
+uint8_t adpcm_encode(AdpcmState* state, int16_t sample);
+
+// ============================================================================
+// Voice Activity Detection (VAD) and level meter
+// Energies are per-frame mean squares (RMS²) of 16-bit samples
+// ============================================================================
+
+#define VAD_FRAME_MAX 320            // 20ms at 16kHz
+#define VAD_FRAMES_PER_SECOND 50     // 20ms frames
+
+typedef struct {
+    // Current frame (held until the frame's keep/drop decision is made)
+    int16_t frame[VAD_FRAME_MAX];
+    int frame_size;                  // Samples per frame (20ms at the output rate)
+    int frame_pos;
+    uint64_t energy_sum;             // Running sum of squares for the frame
+    int zero_crossings;              // Sign changes within the frame
+    int16_t last_sample;
+    int32_t frame_peak;              // Largest magnitude within the frame
+    uint32_t noise_floor;
+    int holdover;                    // Frames remaining in holdover
+    int speech;                      // Last decision (keep/drop)
+
+    // Meter state, all Q15 magnitudes (32768 = full scale)
+    uint32_t level_energy;           // Mean square, instant attack / decaying release
+    int32_t level_peak;              // Held peak magnitude
+    int level_peak_hold;             // Frames left before the peak decays
+} VadState;
+
+void vad_reset(VadState* vad, int frame_size);
+
+// Add a sample to the current frame; returns 1 when the frame is complete
+static inline int vad_accumulate(VadState* vad, int16_t sample) {
+    vad->frame[vad->frame_pos++] = sample;
+    vad->energy_sum += (uint64_t)((int32_t)sample * sample);
+    vad->zero_crossings += (sample ^ vad->last_sample) < 0;
+    vad->last_sample = sample;
+    int32_t magnitude = sample < 0 ? -(int32_t)sample : sample;
+    if (magnitude > vad->frame_peak) {
+        vad->frame_peak = magnitude;
+    }
+    return vad->frame_pos == vad->frame_size;
+}
+
+// Decide whether the completed frame contains speech, then start a new frame
+int vad_decide(VadState* vad);
+
+// Integer square root (mean square → RMS); called per query, not per sample
+uint32_t isqrt32(uint32_t value);
+
+// ============================================================================
+// Polyphase Resampler (Q15 fixed point)
+// ============================================================================
+
+#define RS_TAPS        64            // Taps per phase (filter length at the input rate)
+#define RS_MAX_PHASES  160           // Interpolation factor L for 16kHz output
+#define RS_BLOCK       256           // Input samples resampled per pass
+
+typedef struct {
+    int16_t coeffs[RS_MAX_PHASES * RS_TAPS];  // Phase-major, taps reversed
+    int16_t buffer[RS_TAPS - 1 + RS_BLOCK];   // Filter history + current block
+    int16_t output[RS_BLOCK];                 // Resampled block
+    int rate;                        // Output rate coeffs was built for (0 = none)
+    int interp;                      // L
+    int decim_step;                  // M / L (whole input samples per output)
+    int phase_step;                  // M % L
+    int phase;                       // Current filter phase (0..L-1)
+    int position;                    // buffer index of the newest input for the next output
+} Resampler;
+
+// Build coefficient tables for out_rate (once per rate) and reset filter state
+// (zero the struct before the first call)
+void resampler_init(Resampler* rs, int out_rate);
+
+// Resample up to RS_BLOCK input samples into rs->output; returns samples produced
+int resample_block(Resampler* rs, const int16_t* in, int len);
+
+#endif // DSP_CORE_H
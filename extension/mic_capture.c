@@ -1,62 +1,189 @@
 /*
  * CrankScribe Microphone Capture Extension
  *
- * Captures audio from Playdate's microphone, downsamples from 44.1kHz to 8kHz,
- * applies μ-law compression and VAD for efficient upload.
+ * Captures audio from Playdate's microphone, resamples from 44.1kHz to 8kHz
+ * (or 16kHz) with a fixed-point polyphase filter, applies μ-law compression
+ * and VAD for efficient upload.
  *
- * Compression chain: 44.1kHz 16-bit → 8kHz 16-bit → 8kHz 8-bit μ-law → VAD filtered
- * Results in ~95% size reduction vs raw audio.
+ * Compression chain: 44.1kHz 16-bit → 8kHz 16-bit → 8-bit μ-law or 4-bit IMA-ADPCM → VAD filtered
+ * Results in ~95% size reduction vs raw audio (~97% with ADPCM).
  */
 
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
 #include "pd_api.h"
+#include "dsp_core.h"
 
 static PlaydateAPI* pd = NULL;
 
 // Audio configuration
-#define SAMPLE_RATE_INPUT   44100   // Playdate native sample rate
 #define SAMPLE_RATE_OUTPUT  8000    // 8kHz for aggressive compression (server resamples to 16kHz)
-#define DOWNSAMPLE_FACTOR   5.5125f // 44100/8000
+#define SAMPLE_RATE_WIDE    16000   // Optional wideband output (no server-side resampling)
+static int output_rate = SAMPLE_RATE_OUTPUT;  // Selected via mic.setSampleRate()
 
 // Recording state
 static int is_recording = 0;
-static int16_t* audio_buffer = NULL;       // Raw 16-bit buffer (for WAV export/backup)
-static uint8_t* compressed_buffer = NULL;  // μ-law compressed buffer (for upload)
-static size_t buffer_size = 0;             // Allocated size in samples
-static size_t buffer_position = 0;         // Current write position in samples
-static size_t compressed_position = 0;     // Position in compressed buffer
-static float current_level = 0.0f;
-
-// Initial buffer size: 30 seconds at 8kHz (grows as needed)
-#define INITIAL_BUFFER_SAMPLES (8000 * 30)
-#define BUFFER_GROW_SAMPLES    (8000 * 30)  // Grow by 30 seconds
-
-// Chunk tracking for progressive upload (30 second chunks)
-#define CHUNK_DURATION_SECONDS 30   // 30 seconds per chunk for progressive upload
-#define CHUNK_SAMPLES (8000 * CHUNK_DURATION_SECONDS)
-static int chunk_ready = 0;
-static uint8_t* chunk_buffer = NULL;  // Compressed chunk for upload
-static size_t chunk_size = 0;
-static int chunk_sequence = 0;        // Sequence number for ordering
-
-// VAD (Voice Activity Detection) configuration
-#define VAD_FRAME_SIZE 160           // 20ms at 8kHz
-#define VAD_THRESHOLD 300            // Energy threshold (tunable)
-#define VAD_HOLDOVER_FRAMES 25       // Keep ~500ms after speech ends
-static int vad_holdover = 0;         // Frames remaining in holdover
+static int16_t* audio_buffer = NULL;       // In-memory backup (rest of the pool, after a WAV header)
+static size_t buffer_size = 0;             // Capacity in samples
+static size_t buffer_position = 0;         // Samples recorded (also drives the duration)
+
+// Capture pool
+// One block allocated at kEventInitLua (MIC_POOL_KB, resized by mic.setPoolSize
+// from the capturePoolKB setting) that every recording buffer is carved from:
+// ring slots and frame maps, overlap history, spool entries and read buffer,
+// then backup blocks. mic.startRecording() resets the arena and carves it for
+// the session's rate, chunk length and overlap, so buffers are recycled across
+// recordings, the audio callback never allocates and the heap doesn't fragment.
+// Without a backup path the in-memory backup gets whatever is left.
+#ifndef MIC_POOL_KB
+#define MIC_POOL_KB 2048             // Fits 8kHz up to ~45s chunks, 16kHz up to ~20s
+#endif
+#define MIC_POOL_KB_MIN 256          // Range accepted by mic.setPoolSize()
+#define MIC_POOL_KB_MAX 8192
+#define POOL_ALIGN 8
+static uint8_t* pool = NULL;
+static size_t pool_size = 0;         // Bytes allocated
+static size_t pool_used = 0;         // Bytes carved for the current session (may exceed pool_size on failure)
+
+// Chunk tracking for progressive upload (30 second chunks by default)
+#define CHUNK_DURATION_SECONDS 30   // Default seconds per chunk for progressive upload
+#define CHUNK_DURATION_MIN 5        // Range accepted by mic.setChunkDuration()
+#define CHUNK_DURATION_MAX 60
+#define CHUNK_OVERLAP_MAX_MS 500    // Longest overlap repeated at the start of a chunk
+static int chunk_duration = CHUNK_DURATION_SECONDS;  // Selected via mic.setChunkDuration()
+static int chunk_overlap_ms = 0;                     // Audio repeated from the previous chunk
+static size_t chunk_samples = SAMPLE_RATE_OUTPUT * CHUNK_DURATION_SECONDS;  // At output_rate
+static int chunk_frames = 0;          // VAD frames of recording time per chunk
+static int chunk_sequence = 0;        // Sequence number of the last chunk produced
+static int last_chunk_sequence = 0;   // Sequence number of the last chunk handed to Lua
+
+// Chunk ring: single producer (micCallback) / single consumer (mic.getChunk)
+// Slots are allocated once and reused, so the audio callback never allocates.
+// The callback encodes straight into the slot at ring_head; mic.getChunk pushes
+// the slot at ring_tail to Lua and releases it. Each index is written by one side only.
+#define CHUNK_RING_SLOTS 4           // Four chunks of slack for a late Lua consumer
+typedef struct {
+    uint8_t* data;                   // ring_slot_capacity bytes of encoded audio
+    size_t size;                     // Bytes of valid data
+    int sequence;                    // Chunk sequence number
+    uint16_t* frame_map;             // Kept/dropped frame runs (see Frame Map)
+    int frame_map_count;             // Runs in frame_map
+    int overlap_frames;              // Frames at the start repeated from the previous chunk
+} ChunkSlot;
+static ChunkSlot chunk_ring[CHUNK_RING_SLOTS];
+static size_t ring_slot_capacity = 0;  // Bytes carved per slot
+static int ring_map_capacity = 0;      // Frame map entries carved per slot
+
+// Frame map: run lengths of VAD frames for the chunk being produced, alternating
+// kept, dropped, kept, ... (always starting with kept, which may be 0). Sent with
+// each chunk so the server can rebuild original timing around VAD gaps.
+static uint16_t* frame_map = NULL;   // Producer staging, copied into the slot on publish
+static int frame_map_count = 0;      // Runs so far (last one is still growing)
+static int frame_map_frames = 0;     // Frames covered so far
+
+// Overlap: the last few frames of each chunk are kept and re-encoded at the
+// start of the next, so words cut at a boundary appear whole in one chunk.
+// Repeated frames are not in the frame map; overlap_frames tells the server.
+static int16_t* overlap_history = NULL;  // overlap_capacity frames of samples
+static uint8_t overlap_kept[CHUNK_OVERLAP_MAX_MS / 20];  // Whether each frame was kept
+static int overlap_capacity = 0;     // Frames of history (chunk_overlap_ms / 20)
+static int overlap_next = 0;         // History frame to overwrite next (oldest)
+static int overlap_count = 0;        // Frames of history filled
+static int overlap_pending = 0;      // Replay history into the next chunk
+static int slot_overlap_frames = 0;  // Frames replayed into the current slot
+static uint32_t ring_head = 0;       // Slots published (producer-owned)
+static uint32_t ring_tail = 0;       // Slots consumed (consumer-owned)
+static size_t slot_position = 0;     // Write position in the producer's current slot
+static int ring_overruns = 0;        // Chunks lost because every slot was still pending
+
+// Compression stats for the session (producer-owned, read by mic.poll)
+static uint32_t stat_frames_kept = 0;      // VAD frames encoded into chunks
+static uint32_t stat_frames_dropped = 0;   // VAD frames skipped (silence or full ring)
+static uint32_t stat_bytes_encoded = 0;    // Compressed bytes published in chunks
+static uint32_t stat_frames_lost = 0;      // Speech frames dropped because the ring was full
+static uint32_t stat_oom_events = 0;       // In-memory backup filled the pool
+static uint32_t stat_callbacks = 0;        // micCallback invocations
+static uint64_t stat_callback_us = 0;      // Total time spent in micCallback
+static uint32_t stat_callback_min_us = 0;
+static uint32_t stat_callback_max_us = 0;
+
+// Streaming backup (bounded memory)
+// When mic.startRecording() is given a backup path, 16-bit samples go into a
+// small ring of fixed blocks instead of audio_buffer. mic.update()
+// writes finished blocks to the WAV file from the main thread (no file I/O in
+// the audio callback), and the header is patched with real sizes at stop.
+#define BACKUP_BLOCK_SAMPLES 4096    // ~0.5s at 8kHz per block
+#define BACKUP_BLOCKS 16             // ~8s of slack for the main loop to write
+#define BACKUP_PATH_MAX 128
+static int streaming_backup = 0;             // 1 = backup streams to file
+static SDFile* backup_file = NULL;
+static char backup_path[BACKUP_PATH_MAX];
+static int16_t* backup_blocks = NULL;        // BACKUP_BLOCKS * BACKUP_BLOCK_SAMPLES, from the pool
+static uint32_t backup_head = 0;             // Blocks filled (producer-owned)
+static uint32_t backup_tail = 0;             // Blocks written to disk (consumer-owned)
+static size_t backup_block_position = 0;     // Write position in the producer's current block
+static size_t backup_samples_written = 0;    // Samples on disk
+static size_t backup_samples_dropped = 0;    // Samples lost because the disk fell behind
+
+// Chunk spool (durable upload queue)
+// When mic.startRecording() is given a spool path, mic.update() moves published
+// chunks from the ring straight into an append-only file, so pending uploads
+// live on disk instead of in Lua strings. Lua reads a chunk back only while
+// uploading it (mic.spoolRead) and acks it when the server has it; once every
+// chunk is acked the file is truncated.
+//
+// File: "CSSP" + uint16 version + uint16 reserved, then per chunk a SpoolRecord
+// header followed by frame map bytes and audio bytes (CRC-32 over both).
+// The entry index holds SPOOL_ENTRIES_MAX chunks; acked entries are compacted
+// away when it fills, so only a backlog that long of unacked chunks loses any.
+#define SPOOL_MAGIC "CSSP"
+#define SPOOL_RECORD_MAGIC "CSCK"
+#define SPOOL_VERSION 1
+#define SPOOL_FILE_HEADER_SIZE 8
+#define SPOOL_ENTRIES_MAX 256
+typedef struct {
+    char magic[4];                   // "CSCK"
+    uint32_t sequence;
+    uint32_t map_bytes;              // Frame map bytes (first part of payload)
+    uint32_t audio_bytes;            // Encoded audio bytes (rest of payload)
+    uint16_t overlap_frames;
+    uint16_t reserved;
+    uint32_t crc;                    // CRC-32 of the payload
+} SpoolRecord;
+typedef struct {
+    int sequence;
+    uint32_t offset;                 // File offset of the record header
+    uint32_t size;                   // Payload bytes
+    int acked;
+} SpoolEntry;
+static int spool_enabled = 0;                // 1 = chunks go to the spool file
+static SDFile* spool_file = NULL;            // Append handle (reads use their own)
+static char spool_path[BACKUP_PATH_MAX];
+static SpoolEntry* spool_entries = NULL;     // Chunks in the file, in order (SPOOL_ENTRIES_MAX, from the pool)
+static int spool_count = 0;                  // Entries in use
+static int spool_unacked = 0;                // Entries not yet acked
+static uint32_t spool_size = 0;              // File size in bytes
+static int spool_last_sequence = 0;          // Highest sequence spooled
+static int spool_write_errors = 0;           // Chunks lost to failed writes
+static uint8_t* spool_scratch = NULL;        // Main-thread buffer for reads (one record, from the pool)
+static size_t spool_scratch_size = 0;
+
+// Codec selection (mic.setCodec)
+typedef enum {
+    CODEC_MULAW = 0,                 // G.711 μ-law, 8 bits/sample
+    CODEC_ADPCM = 1,                 // IMA-ADPCM, 4 bits/sample + 4-byte header per chunk
+    CODEC_COUNT
+} Codec;
+static const char* codec_names[CODEC_COUNT] = { "mulaw", "adpcm" };
+static Codec codec = CODEC_MULAW;
+static uint32_t stat_codec_bytes[CODEC_COUNT];  // Compressed bytes per codec since launch
+
+// DSP stages (see dsp_core.h); the VAD also drives the level meter
+static Resampler resampler;
+static VadState vad;
+static int vad_frame_size = 160;     // 20ms at output_rate
 static int vad_enabled = 1;          // Can be disabled for testing
 
-// μ-law encoding lookup table (ITU G.711 standard)
-static uint8_t mulaw_encode_table[65536];
-static int mulaw_table_initialized = 0;
-
-// Downsampling state
-static float sample_accumulator = 0.0f;
-static float accumulated_samples = 0.0f;
-static int sample_count = 0;
-
 // WAV header structure
 typedef struct {
     char riff[4];           // "RIFF"
@@ -75,79 +202,271 @@ typedef struct {
 } WavHeader;
 
 // ============================================================================
-// μ-law Compression (ITU G.711 standard)
-// Reduces 16-bit samples to 8-bit with logarithmic compression
-// Optimized for speech - maintains quality while halving size
+// Capture Pool
+// Bump allocator over the block allocated at init (main thread only)
 // ============================================================================
 
-// Initialize μ-law encoding lookup table
-static void init_mulaw_table(void) {
-    if (mulaw_table_initialized) return;
+// Replace the pool with one of kb kilobytes; everything carved from the old
+// one is gone, so not while recording or spooling. On failure the old pool is kept
+static int pool_alloc(int kb) {
+    size_t size = (size_t)kb * 1024;
+    if (pool && size == pool_size) return 1;
+
+    uint8_t* block = (uint8_t*)pd->system->realloc(pool, size);
+    if (!block) return 0;
+    pool = block;
+    pool_size = size;
+    pool_used = 0;
+    ring_head = 0;  // Chunks left in the old ring
+    ring_tail = 0;
+    return 1;
+}
 
-    // μ-law encoding formula: F(x) = sgn(x) * ln(1 + μ|x|) / ln(1 + μ)
-    // where μ = 255 for standard G.711
-    const int BIAS = 0x84;
-    const int CLIP = 32635;
+// Forget every carve; buffers from the last session become invalid
+static inline void pool_reset(void) {
+    pool_used = 0;
+}
 
-    for (int i = 0; i < 65536; i++) {
-        int16_t sample = (int16_t)i;
-        int sign = (sample >> 8) & 0x80;
+// Take bytes from the pool, or NULL when it is exhausted (pool_used still
+// advances, so after a failed session carve it holds the size needed)
+static void* pool_carve(size_t bytes) {
+    size_t offset = (pool_used + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    pool_used = offset + bytes;
+    if (!pool || pool_used > pool_size) return NULL;
+    return pool + offset;
+}
+
+// ============================================================================
+// Chunk Ring
+// Lock-free hand-off of compressed chunks from the audio callback to Lua
+// ============================================================================
 
-        if (sign) sample = -sample;
-        if (sample > CLIP) sample = CLIP;
+static inline uint32_t ring_load(const uint32_t* index) {
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
 
-        sample += BIAS;
+static inline void ring_store(uint32_t* index, uint32_t value) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
 
-        int exponent = 7;
-        for (int exp_mask = 0x4000; exp_mask > 0x80; exp_mask >>= 1) {
-            if (sample & exp_mask) break;
-            exponent--;
-        }
+// Carve ring slots, frame maps and overlap history for the session's chunk
+// size and overlap (main thread, after pool_reset)
+static int ring_carve(void) {
+    // One run per frame at worst, plus the leading (possibly empty) kept run
+    int map_capacity = chunk_frames + 2;
+    // Room for the repeated overlap and the ADPCM header on top of the chunk
+    int history_capacity = chunk_overlap_ms / 20;
+    size_t slot_capacity = chunk_samples + (size_t)history_capacity * vad_frame_size + 4;
+    int ok = 1;
+
+    overlap_history = NULL;
+    if (history_capacity) {
+        overlap_history = (int16_t*)pool_carve((size_t)history_capacity * vad_frame_size * sizeof(int16_t));
+        ok = overlap_history != NULL;
+    }
+    overlap_capacity = history_capacity;
+
+    frame_map = (uint16_t*)pool_carve(map_capacity * sizeof(uint16_t));
+    ok = ok && frame_map;
+
+    for (int i = 0; i < CHUNK_RING_SLOTS; i++) {
+        chunk_ring[i].data = (uint8_t*)pool_carve(slot_capacity);
+        chunk_ring[i].frame_map = (uint16_t*)pool_carve(map_capacity * sizeof(uint16_t));
+        ok = ok && chunk_ring[i].data && chunk_ring[i].frame_map;
+        chunk_ring[i].size = 0;
+        chunk_ring[i].sequence = 0;
+        chunk_ring[i].frame_map_count = 0;
+        chunk_ring[i].overlap_frames = 0;
+    }
+    ring_slot_capacity = slot_capacity;
+    ring_map_capacity = map_capacity;
+    return ok;
+}
+
+// ============================================================================
+// Frame Map
+// Run-length record of which VAD frames made it into the chunk
+// ============================================================================
 
-        int mantissa = (sample >> (exponent + 3)) & 0x0F;
-        mulaw_encode_table[i] = ~(sign | (exponent << 4) | mantissa);
+static inline void frame_map_reset(void) {
+    frame_map[0] = 0;  // Leading kept run
+    frame_map_count = 1;
+    frame_map_frames = 0;
+}
+
+// Record one frame as kept (1) or dropped (0)
+static inline void frame_map_add(int kept) {
+    // Even-indexed runs are kept, odd-indexed runs are dropped
+    int current_kept = ((frame_map_count - 1) & 1) == 0;
+    if (current_kept != kept && frame_map_count < ring_map_capacity) {
+        frame_map[frame_map_count++] = 0;
     }
+    frame_map[frame_map_count - 1]++;
+    frame_map_frames++;
+}
 
-    mulaw_table_initialized = 1;
+// Producer: slot currently being filled, or NULL if the consumer has fallen behind
+static inline ChunkSlot* ring_write_slot(void) {
+    uint32_t head = ring_head;
+    if (head - ring_load(&ring_tail) >= CHUNK_RING_SLOTS) return NULL;
+    return &chunk_ring[head % CHUNK_RING_SLOTS];
 }
 
-// Encode single 16-bit sample to 8-bit μ-law
-static inline uint8_t mulaw_encode(int16_t sample) {
-    return mulaw_encode_table[(uint16_t)sample];
+// Producer: append one compressed byte to the current chunk
+static inline void ring_write(uint8_t value) {
+    ChunkSlot* slot = ring_write_slot();
+    if (!slot || slot_position >= ring_slot_capacity) return;
+    slot->data[slot_position++] = value;
+}
+
+// Producer: publish the current chunk (audio + frame map) to the consumer
+// All-silence chunks are still published (empty audio) so the server keeps timing
+static void ring_publish(void) {
+    ChunkSlot* slot = ring_write_slot();
+    if (!slot) {
+        ring_overruns++;
+        frame_map_reset();
+        return;
+    }
+    if (frame_map_frames == 0 && slot_position == 0) return;  // Nothing recorded
+
+    memcpy(slot->frame_map, frame_map, frame_map_count * sizeof(uint16_t));
+    slot->frame_map_count = frame_map_count;
+    slot->overlap_frames = slot_overlap_frames;
+    slot->size = slot_position;
+    slot->sequence = ++chunk_sequence;
+    stat_bytes_encoded += slot_position;
+    stat_codec_bytes[codec] += slot_position;
+    slot_position = 0;
+    slot_overlap_frames = 0;
+    overlap_pending = overlap_capacity > 0;
+    frame_map_reset();
+    ring_store(&ring_head, ring_head + 1);
+}
+
+// Consumer: oldest published chunk, or NULL if none pending
+static inline ChunkSlot* ring_read_slot(void) {
+    uint32_t tail = ring_tail;
+    if (tail == ring_load(&ring_head)) return NULL;
+    return &chunk_ring[tail % CHUNK_RING_SLOTS];
+}
+
+// Consumer: return the oldest chunk's slot to the producer
+static inline void ring_release(void) {
+    ring_store(&ring_tail, ring_tail + 1);
 }
 
 // ============================================================================
-// Voice Activity Detection (VAD)
-// Simple energy-based detector to skip silence and reduce upload size
+// Encoder Stage
+// Pluggable codec between VAD and the chunk ring. IMA-ADPCM packs two samples
+// per byte, first sample in the high nibble (matches Python's audioop). Each
+// ADPCM chunk starts with a 4-byte header holding the encoder state (int16 LE
+// predictor, uint8 step index, 0) so chunks decode independently on the server.
 // ============================================================================
 
-// VAD frame buffer for energy calculation
-static int16_t vad_frame[VAD_FRAME_SIZE];
-static int vad_frame_pos = 0;
+static AdpcmState adpcm;
+static int adpcm_pending = -1;       // High nibble awaiting its low nibble (-1 = none)
 
-// Calculate frame energy and determine if speech is present
-static int frame_has_speech(void) {
-    if (vad_frame_pos < VAD_FRAME_SIZE) return 1;  // Not enough samples yet
+static void encoder_reset(void) {
+    adpcm_reset(&adpcm);
+    adpcm_pending = -1;
+}
 
-    // Calculate mean absolute energy (simpler than RMS, good enough for VAD)
-    int32_t energy = 0;
-    for (int i = 0; i < VAD_FRAME_SIZE; i++) {
-        energy += abs(vad_frame[i]);
+// Encode one VAD-kept sample into the current chunk
+static inline void encoder_write(int16_t sample) {
+    if (codec == CODEC_MULAW) {
+        ring_write(mulaw_encode(sample));
+        return;
     }
-    energy /= VAD_FRAME_SIZE;
 
-    if (energy > VAD_THRESHOLD) {
-        vad_holdover = VAD_HOLDOVER_FRAMES;  // Reset holdover when speech detected
-        return 1;
+    // ADPCM: chunk header carries the state the decoder starts from
+    if (slot_position == 0) {
+        ring_write((uint8_t)(adpcm.predictor & 0xFF));
+        ring_write((uint8_t)((adpcm.predictor >> 8) & 0xFF));
+        ring_write((uint8_t)adpcm.index);
+        ring_write(0);
+        adpcm_pending = -1;
     }
 
-    // During holdover period, still output (prevents cutting off word endings)
-    if (vad_holdover > 0) {
-        vad_holdover--;
-        return 1;
+    uint8_t code = adpcm_encode(&adpcm, sample);
+    if (adpcm_pending < 0) {
+        adpcm_pending = code << 4;
+    } else {
+        ring_write((uint8_t)(adpcm_pending | code));
+        adpcm_pending = -1;
+    }
+}
+
+// Encode a run of VAD-kept samples (μ-law a block at a time, straight into
+// the slot; bytes past the slot's end are dropped, as in ring_write)
+static inline void encoder_write_frame(const int16_t* samples, int count) {
+    if (codec == CODEC_MULAW) {
+        ChunkSlot* slot = ring_write_slot();
+        if (!slot || slot_position >= ring_slot_capacity) return;
+        size_t room = ring_slot_capacity - slot_position;
+        int n = (size_t)count < room ? count : (int)room;
+        mulaw_encode_block(samples, slot->data + slot_position, n);
+        slot_position += (size_t)n;
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        encoder_write(samples[i]);
+    }
+}
+
+// Re-encode the previous chunk's last kept frames at the start of a new chunk
+static void overlap_replay(void) {
+    overlap_pending = 0;
+    if (!ring_write_slot()) return;
+
+    int oldest = (overlap_next - overlap_count + overlap_capacity) % overlap_capacity;
+    for (int f = 0; f < overlap_count; f++) {
+        int index = (oldest + f) % overlap_capacity;
+        if (!overlap_kept[index]) continue;
+        encoder_write_frame(overlap_history + index * vad_frame_size, vad_frame_size);
+        slot_overlap_frames++;
+    }
+}
+
+// Remember a frame for the next chunk's overlap
+static inline void overlap_push(int count, int keep) {
+    memcpy(overlap_history + overlap_next * vad_frame_size, vad.frame, count * sizeof(int16_t));
+    overlap_kept[overlap_next] = (uint8_t)(keep && count == vad_frame_size);
+    overlap_next = (overlap_next + 1) % overlap_capacity;
+    if (overlap_count < overlap_capacity) overlap_count++;
+}
+
+// Encode the current VAD frame's samples into the chunk and record it in the
+// frame map (as dropped if the ring is full and the audio can't be stored)
+static inline void encode_frame(int count, int keep) {
+    if (overlap_pending) {
+        overlap_replay();
+    }
+    if (keep && !ring_write_slot()) {
+        keep = 0;
+        stat_frames_lost++;
+    }
+    if (keep) {
+        encoder_write_frame(vad.frame, count);
+    }
+    frame_map_add(keep);
+    if (keep) {
+        stat_frames_kept++;
+    } else {
+        stat_frames_dropped++;
+    }
+    if (overlap_capacity) {
+        overlap_push(count, keep);
     }
+}
 
-    return 0;  // Silence - skip this frame
+// Close out the current chunk (flushes a half-filled ADPCM byte) and publish it
+static void encoder_publish(void) {
+    if (adpcm_pending >= 0) {
+        ring_write((uint8_t)adpcm_pending);
+        adpcm_pending = -1;
+    }
+    ring_publish();
 }
 
 // ============================================================================
@@ -157,7 +476,306 @@ static int frame_has_speech(void) {
 static int micCallback(void* context, int16_t* data, int len);
 static void createWavHeader(WavHeader* header, size_t num_samples);
 
-// Lua function: mic.startRecording()
+// ============================================================================
+// Streaming Backup
+// 16-bit backup WAV written incrementally in fixed blocks
+// ============================================================================
+
+// Open the backup file and write a placeholder header (main thread, blocks
+// already carved)
+static int backup_open(const char* path) {
+    backup_file = pd->file->open(path, kFileWrite);
+    if (!backup_file) {
+        pd->system->logToConsole("Failed to open backup file %s: %s", path, pd->file->geterr());
+        return 0;
+    }
+
+    strncpy(backup_path, path, BACKUP_PATH_MAX - 1);
+    backup_path[BACKUP_PATH_MAX - 1] = '\0';
+
+    WavHeader header;
+    createWavHeader(&header, 0);
+    pd->file->write(backup_file, &header, sizeof(WavHeader));
+
+    backup_head = 0;
+    backup_tail = 0;
+    backup_block_position = 0;
+    backup_samples_written = 0;
+    backup_samples_dropped = 0;
+    return 1;
+}
+
+// Producer: append one sample to the current block (audio callback)
+static inline void backup_write(int16_t sample) {
+    uint32_t head = backup_head;
+    if (head - ring_load(&backup_tail) >= BACKUP_BLOCKS) {
+        backup_samples_dropped++;
+        return;
+    }
+
+    int16_t* block = backup_blocks + (head % BACKUP_BLOCKS) * BACKUP_BLOCK_SAMPLES;
+    block[backup_block_position++] = sample;
+    if (backup_block_position == BACKUP_BLOCK_SAMPLES) {
+        backup_block_position = 0;
+        ring_store(&backup_head, head + 1);
+    }
+}
+
+// Write samples to the backup file, logging (not failing) on short writes
+static void backup_write_file(const int16_t* samples, size_t count) {
+    int bytes = (int)(count * sizeof(int16_t));
+    if (pd->file->write(backup_file, samples, (unsigned int)bytes) != bytes) {
+        pd->system->logToConsole("Backup write failed: %s", pd->file->geterr());
+        return;
+    }
+    backup_samples_written += count;
+}
+
+// Consumer: write every filled block to disk (main thread)
+static void backup_flush(void) {
+    if (!backup_file) return;
+
+    uint32_t tail = backup_tail;
+    while (tail != ring_load(&backup_head)) {
+        backup_write_file(backup_blocks + (tail % BACKUP_BLOCKS) * BACKUP_BLOCK_SAMPLES,
+                          BACKUP_BLOCK_SAMPLES);
+        tail++;
+        ring_store(&backup_tail, tail);
+    }
+}
+
+// Flush remaining samples, patch the header and close (callback must be stopped)
+static void backup_close(void) {
+    if (!backup_file) return;
+
+    backup_flush();
+    if (backup_block_position > 0) {
+        backup_write_file(backup_blocks + (backup_head % BACKUP_BLOCKS) * BACKUP_BLOCK_SAMPLES,
+                          backup_block_position);
+        backup_block_position = 0;
+    }
+
+    WavHeader header;
+    createWavHeader(&header, backup_samples_written);
+    pd->file->seek(backup_file, 0, SEEK_SET);
+    pd->file->write(backup_file, &header, sizeof(WavHeader));
+    pd->file->close(backup_file);
+    backup_file = NULL;
+
+    if (backup_samples_dropped > 0) {
+        pd->system->logToConsole("Backup dropped %d samples (disk fell behind)", (int)backup_samples_dropped);
+    }
+}
+
+// ============================================================================
+// Chunk Spool
+// Append-only on-disk queue of chunks awaiting upload (main thread only)
+// ============================================================================
+
+// CRC-32 (IEEE), nibble table - spool integrity check on read-back
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+// Start (or restart) an empty spool file
+static int spool_reset_file(void) {
+    if (spool_file) {
+        pd->file->close(spool_file);
+    }
+    spool_file = pd->file->open(spool_path, kFileWrite);
+    if (!spool_file) {
+        pd->system->logToConsole("Failed to open spool %s: %s", spool_path, pd->file->geterr());
+        return 0;
+    }
+
+    uint8_t header[SPOOL_FILE_HEADER_SIZE] = { 'C', 'S', 'S', 'P', SPOOL_VERSION, 0, 0, 0 };
+    pd->file->write(spool_file, header, SPOOL_FILE_HEADER_SIZE);
+    pd->file->flush(spool_file);
+
+    spool_count = 0;
+    spool_unacked = 0;
+    spool_size = SPOOL_FILE_HEADER_SIZE;
+    return 1;
+}
+
+static int spool_open(const char* path) {
+    strncpy(spool_path, path, BACKUP_PATH_MAX - 1);
+    spool_path[BACKUP_PATH_MAX - 1] = '\0';
+    spool_last_sequence = 0;
+    spool_write_errors = 0;
+    return spool_reset_file();
+}
+
+// Drop acked entries from the index (their records stay in the file until
+// it is truncated, but are never read again)
+static void spool_compact(void) {
+    int kept = 0;
+    for (int i = 0; i < spool_count; i++) {
+        if (!spool_entries[i].acked) {
+            spool_entries[kept++] = spool_entries[i];
+        }
+    }
+    spool_count = kept;
+}
+
+// Append one chunk's record (header + frame map + audio)
+static void spool_append(const ChunkSlot* slot) {
+    if (!spool_file) return;
+
+    if (spool_count == SPOOL_ENTRIES_MAX) {
+        spool_compact();
+        if (spool_count == SPOOL_ENTRIES_MAX) {
+            spool_write_errors++;  // Upload backlog longer than the index
+            return;
+        }
+    }
+
+    uint32_t map_bytes = (uint32_t)(slot->frame_map_count * sizeof(uint16_t));
+    SpoolRecord record;
+    memcpy(record.magic, SPOOL_RECORD_MAGIC, 4);
+    record.sequence = (uint32_t)slot->sequence;
+    record.map_bytes = map_bytes;
+    record.audio_bytes = (uint32_t)slot->size;
+    record.overlap_frames = (uint16_t)slot->overlap_frames;
+    record.reserved = 0;
+    record.crc = crc32_update(crc32_update(0, (const uint8_t*)slot->frame_map, map_bytes),
+                              slot->data, slot->size);
+
+    int ok = pd->file->write(spool_file, &record, sizeof(record)) == (int)sizeof(record) &&
+             pd->file->write(spool_file, slot->frame_map, map_bytes) == (int)map_bytes &&
+             pd->file->write(spool_file, slot->data, (unsigned int)slot->size) == (int)slot->size;
+    pd->file->flush(spool_file);
+    if (!ok) {
+        // Start over at the last good record so later appends stay readable
+        pd->system->logToConsole("Spool write failed: %s", pd->file->geterr());
+        pd->file->seek(spool_file, (int)spool_size, SEEK_SET);
+        spool_write_errors++;
+        return;
+    }
+
+    SpoolEntry* entry = &spool_entries[spool_count++];
+    entry->sequence = slot->sequence;
+    entry->offset = spool_size;
+    entry->size = map_bytes + (uint32_t)slot->size;
+    entry->acked = 0;
+    spool_unacked++;
+    spool_size += sizeof(record) + entry->size;
+    spool_last_sequence = slot->sequence;
+}
+
+// Move every published chunk from the ring into the spool
+static void spool_drain(void) {
+    ChunkSlot* slot;
+    while ((slot = ring_read_slot()) != NULL) {
+        spool_append(slot);
+        last_chunk_sequence = slot->sequence;
+        ring_release();
+    }
+}
+
+static SpoolEntry* spool_find(int sequence) {
+    for (int i = 0; i < spool_count; i++) {
+        if (spool_entries[i].sequence == sequence) return &spool_entries[i];
+    }
+    return NULL;
+}
+
+// Read a chunk's record back into spool_scratch and verify it
+static const SpoolRecord* spool_read(const SpoolEntry* entry) {
+    size_t needed = sizeof(SpoolRecord) + entry->size;
+    if (needed > spool_scratch_size) return NULL;  // Records are at most one slot (see session_carve)
+
+    SDFile* file = pd->file->open(spool_path, kFileReadData);
+    if (!file) return NULL;
+    pd->file->seek(file, (int)entry->offset, SEEK_SET);
+    int read = pd->file->read(file, spool_scratch, (unsigned int)needed);
+    pd->file->close(file);
+
+    const SpoolRecord* record = (const SpoolRecord*)spool_scratch;
+    if (read != (int)needed || memcmp(record->magic, SPOOL_RECORD_MAGIC, 4) != 0 ||
+        record->sequence != (uint32_t)entry->sequence ||
+        record->crc != crc32_update(0, spool_scratch + sizeof(SpoolRecord), entry->size)) {
+        pd->system->logToConsole("Spooled chunk %d is corrupt", entry->sequence);
+        return NULL;
+    }
+    return record;
+}
+
+static void spool_ack(int sequence) {
+    SpoolEntry* entry = spool_find(sequence);
+    if (!entry || entry->acked) return;
+    entry->acked = 1;
+    spool_unacked--;
+
+    // Everything uploaded: truncate (nothing more can arrive while unpublished
+    // chunks are still in the ring, so check that too)
+    if (spool_unacked == 0 && ring_read_slot() == NULL) {
+        spool_reset_file();
+    }
+}
+
+static void spool_close(int remove) {
+    if (spool_file) {
+        pd->file->close(spool_file);
+        spool_file = NULL;
+    }
+    if (remove) {
+        pd->file->unlink(spool_path, 0);
+    }
+    spool_enabled = 0;
+    spool_count = 0;
+    spool_unacked = 0;
+}
+
+// Carve the pool for a session (after pool_reset): chunk ring, then the spool's
+// index and read buffer, then backup blocks - the streaming ring with a backup
+// path, otherwise the rest of the pool behind a WAV header for the in-memory
+// backup. Returns 0 if the pool is too small (pool_used then holds the size needed)
+static int session_carve(int spool, int streaming) {
+    int ok = ring_carve();
+
+    spool_entries = NULL;
+    spool_scratch = NULL;
+    spool_scratch_size = 0;
+    if (spool) {
+        spool_entries = (SpoolEntry*)pool_carve(SPOOL_ENTRIES_MAX * sizeof(SpoolEntry));
+        spool_scratch_size = sizeof(SpoolRecord) + ring_map_capacity * sizeof(uint16_t) + ring_slot_capacity;
+        spool_scratch = (uint8_t*)pool_carve(spool_scratch_size);
+        ok = ok && spool_entries && spool_scratch;
+    }
+
+    backup_blocks = NULL;
+    audio_buffer = NULL;
+    buffer_size = 0;
+    if (streaming) {
+        backup_blocks = (int16_t*)pool_carve(BACKUP_BLOCKS * BACKUP_BLOCK_SAMPLES * sizeof(int16_t));
+        return ok && backup_blocks;
+    }
+
+    // Claim a second's worth at least, so a pool with no room fails here
+    // rather than in the first callback
+    uint8_t* wav = (uint8_t*)pool_carve(sizeof(WavHeader) + (size_t)output_rate * sizeof(int16_t));
+    if (!ok || !wav) return 0;
+    audio_buffer = (int16_t*)(wav + sizeof(WavHeader));
+    buffer_size = (pool_size - (size_t)((uint8_t*)audio_buffer - pool)) / sizeof(int16_t);
+    pool_used = pool_size;
+    return 1;
+}
+
+// Lua function: mic.startRecording([backupPath], [spoolPath])
+// With a backupPath the 16-bit backup streams to that WAV file in fixed blocks;
+// without one it is kept in memory and returned by stopRecording().
+// With a spoolPath chunks are queued on disk (mic.spoolRead/spoolAck) instead of
+// through mic.getChunk
 static int mic_startRecording(lua_State* L) {
     if (is_recording) {
         pd->lua->pushBool(0);
@@ -165,45 +783,76 @@ static int mic_startRecording(lua_State* L) {
         return 2;
     }
 
-    // Initialize μ-law encoding table (once)
-    init_mulaw_table();
+    // Configure the pipeline for the selected output rate and chunk duration
+    chunk_samples = (size_t)output_rate * chunk_duration;
+    vad_frame_size = output_rate / VAD_FRAMES_PER_SECOND;  // 20ms frames
+    chunk_frames = chunk_duration * VAD_FRAMES_PER_SECOND;
+    resampler_init(&resampler, output_rate);
+
+    int spool = pd->lua->getArgCount() >= 2 && !pd->lua->argIsNil(2);
+    int streaming = pd->lua->getArgCount() >= 1 && !pd->lua->argIsNil(1);
 
-    // Allocate raw audio buffer (for backup/WAV export)
-    buffer_size = INITIAL_BUFFER_SAMPLES;
-    audio_buffer = (int16_t*)pd->system->realloc(NULL, buffer_size * sizeof(int16_t));
-    if (!audio_buffer) {
+    // The previous session's buffers are carved over, so its spool (if still
+    // open) goes too
+    if (spool || spool_enabled) {
+        spool_close(1);
+    }
+    pool_reset();
+    if (!session_carve(spool, streaming)) {
+        pd->system->logToConsole("Capture pool is %d KB, session needs %d KB",
+                                 (int)(pool_size / 1024), (int)((pool_used + 1023) / 1024));
+        pool_reset();
         pd->lua->pushBool(0);
-        pd->lua->pushString("Failed to allocate audio buffer");
+        pd->lua->pushString("Capture pool too small");
         return 2;
     }
 
-    // Allocate compressed buffer (same size in samples, but 1 byte each)
-    compressed_buffer = (uint8_t*)pd->system->realloc(NULL, buffer_size);
-    if (!compressed_buffer) {
-        pd->system->realloc(audio_buffer, 0);
-        audio_buffer = NULL;
-        pd->lua->pushBool(0);
-        pd->lua->pushString("Failed to allocate compressed buffer");
-        return 2;
+    if (spool) {
+        if (!spool_open(pd->lua->getArgString(2))) {
+            pd->lua->pushBool(0);
+            pd->lua->pushString("Failed to open chunk spool");
+            return 2;
+        }
+        spool_enabled = 1;
+    }
+
+    streaming_backup = streaming;
+    if (streaming_backup) {
+        // Stream backup to file (constant memory regardless of duration)
+        if (!backup_open(pd->lua->getArgString(1))) {
+            streaming_backup = 0;
+            pd->lua->pushBool(0);
+            pd->lua->pushString("Failed to open backup file");
+            return 2;
+        }
     }
 
     buffer_position = 0;
-    compressed_position = 0;
-    sample_accumulator = 0.0f;
-    accumulated_samples = 0.0f;
-    sample_count = 0;
-    current_level = 0.0f;
-    chunk_ready = 0;
     chunk_sequence = 0;
-    vad_holdover = 0;
-    vad_frame_pos = 0;
-
-    // Clear any previous chunk
-    if (chunk_buffer) {
-        pd->system->realloc(chunk_buffer, 0);
-        chunk_buffer = NULL;
-        chunk_size = 0;
-    }
+    last_chunk_sequence = 0;
+    vad_reset(&vad, vad_frame_size);
+
+    encoder_reset();
+
+    // Discard any chunks left over from a previous session
+    ring_head = 0;
+    ring_tail = 0;
+    slot_position = 0;
+    ring_overruns = 0;
+    stat_frames_kept = 0;
+    stat_frames_dropped = 0;
+    stat_bytes_encoded = 0;
+    stat_frames_lost = 0;
+    stat_oom_events = 0;
+    stat_callbacks = 0;
+    stat_callback_us = 0;
+    stat_callback_min_us = 0;
+    stat_callback_max_us = 0;
+    frame_map_reset();
+    overlap_next = 0;
+    overlap_count = 0;
+    overlap_pending = 0;
+    slot_overlap_frames = 0;
 
     // Start mic capture
     pd->sound->setMicCallback(micCallback, NULL, kMicInputAutodetect);
@@ -213,7 +862,8 @@ static int mic_startRecording(lua_State* L) {
     return 1;
 }
 
-// Lua function: mic.stopRecording() -> returns WAV data as string (backup format)
+// Lua function: mic.stopRecording() -> returns WAV data as string (backup format),
+// or the backup file path when recording was started with one
 static int mic_stopRecording(lua_State* L) {
     if (!is_recording) {
         pd->lua->pushNil();
@@ -225,73 +875,72 @@ static int mic_stopRecording(lua_State* L) {
     pd->sound->setMicCallback(NULL, NULL, kMicInputAutodetect);
     is_recording = 0;
 
-    // Generate final chunk from any remaining compressed data
-    if (compressed_position > 0 && !chunk_ready) {
-        chunk_size = compressed_position;
-        chunk_buffer = (uint8_t*)pd->system->realloc(NULL, chunk_size);
-        if (chunk_buffer) {
-            memcpy(chunk_buffer, compressed_buffer, chunk_size);
-            chunk_ready = 1;
-            chunk_sequence++;
-            pd->system->logToConsole("Final chunk created: %d bytes", (int)chunk_size);
-        }
+    // Keep the trailing partial frame if speech was still in progress
+    // (callback is stopped, so the main thread now owns the producer side)
+    if (vad.frame_pos > 0) {
+        encode_frame(vad.frame_pos, vad.speech || !vad_enabled);
     }
+    vad.frame_pos = 0;
 
-    if (!audio_buffer || buffer_position == 0) {
-        if (audio_buffer) {
-            pd->system->realloc(audio_buffer, 0);
-            audio_buffer = NULL;
-        }
-        if (compressed_buffer) {
-            pd->system->realloc(compressed_buffer, 0);
-            compressed_buffer = NULL;
-        }
-        pd->lua->pushNil();
-        pd->lua->pushString("No audio recorded");
-        return 2;
+    // Publish final chunk from any remaining compressed data
+    if (slot_position > 0 || frame_map_frames > 0) {
+        size_t final_size = slot_position;
+        encoder_publish();
+        pd->system->logToConsole("Final chunk created: %d bytes", (int)final_size);
+    }
+    if (ring_overruns > 0) {
+        pd->system->logToConsole("Chunk ring overran %d time(s)", ring_overruns);
+    }
+    if (spool_enabled) {
+        spool_drain();
     }
 
-    // Create WAV data (8kHz, 16-bit for backup/local storage)
-    WavHeader header;
-    createWavHeader(&header, buffer_position);
+    // Streaming mode: the backup is already on disk - just finish the file
+    if (streaming_backup) {
+        backup_close();
+        streaming_backup = 0;
+        buffer_position = 0;
+
+        if (backup_samples_written == 0) {
+            pd->lua->pushNil();
+            pd->lua->pushString("No audio recorded");
+            return 2;
+        }
 
-    size_t wav_size = sizeof(WavHeader) + (buffer_position * sizeof(int16_t));
-    char* wav_data = (char*)pd->system->realloc(NULL, wav_size);
-    if (!wav_data) {
-        pd->system->realloc(audio_buffer, 0);
+        pd->lua->pushString(backup_path);
+        return 1;
+    }
+
+    if (!audio_buffer || buffer_position == 0) {
         audio_buffer = NULL;
-        pd->system->realloc(compressed_buffer, 0);
-        compressed_buffer = NULL;
         pd->lua->pushNil();
-        pd->lua->pushString("Failed to allocate WAV buffer");
+        pd->lua->pushString("No audio recorded");
         return 2;
     }
 
-    memcpy(wav_data, &header, sizeof(WavHeader));
-    memcpy(wav_data + sizeof(WavHeader), audio_buffer, buffer_position * sizeof(int16_t));
+    // WAV data (8kHz, 16-bit for backup/local storage): the header goes in the
+    // space carved in front of the samples, so it is pushed without a copy
+    char* wav_data = (char*)audio_buffer - sizeof(WavHeader);
+    createWavHeader((WavHeader*)wav_data, buffer_position);
+    pd->lua->pushBytes(wav_data, sizeof(WavHeader) + buffer_position * sizeof(int16_t));
 
-    // Push as Lua string (binary data)
-    pd->lua->pushBytes(wav_data, wav_size);
-
-    // Cleanup (but keep chunk_buffer - it will be retrieved by getChunk())
-    pd->system->realloc(wav_data, 0);
-    pd->system->realloc(audio_buffer, 0);
+    // The pool (and chunk ring - pending chunks are retrieved by getChunk())
+    // is kept until the next recording
     audio_buffer = NULL;
-    pd->system->realloc(compressed_buffer, 0);
-    compressed_buffer = NULL;
     buffer_size = 0;
     buffer_position = 0;
-    compressed_position = 0;
-
-    // NOTE: Don't clear chunk_buffer here - Lua needs to call getChunk() to retrieve it
 
     return 1;
 }
 
-// Lua function: mic.getLevel() -> returns current mic level 0.0-1.0
-static int mic_getLevel(lua_State* L) {
-    pd->lua->pushFloat(current_level);
-    return 1;
+// Lua function: mic.getLevels() -> rms, peak (0.0-1.0), speech (boolean)
+// One call gives the meter everything: smoothed RMS, held peak, and the VAD's
+// last keep/drop decision
+static int mic_getLevels(lua_State* L) {
+    pd->lua->pushFloat(isqrt32(vad.level_energy) / 32768.0f);
+    pd->lua->pushFloat(vad.level_peak / 32768.0f);
+    pd->lua->pushBool(is_recording && vad.speech);
+    return 3;
 }
 
 // Lua function: mic.isRecording() -> returns boolean
@@ -300,34 +949,39 @@ static int mic_isRecording(lua_State* L) {
     return 1;
 }
 
-// Lua function: mic.hasChunk() -> returns boolean (true if 30s compressed chunk ready)
+// Lua function: mic.hasChunk() -> returns boolean (true if a compressed chunk is pending)
 static int mic_hasChunk(lua_State* L) {
-    pd->lua->pushBool(chunk_ready);
+    pd->lua->pushBool(ring_read_slot() != NULL);
     return 1;
 }
 
-// Lua function: mic.getChunk() -> returns μ-law compressed data for upload, clears chunk
+// Lua function: mic.getChunk() -> returns oldest pending chunk, its sequence number,
+// its frame map (uint16 LE runs of 20ms frames: kept, dropped, kept, ...) and the
+// number of overlap frames repeated from the previous chunk at its start
 static int mic_getChunk(lua_State* L) {
-    if (!chunk_ready || !chunk_buffer || chunk_size == 0) {
+    ChunkSlot* slot = ring_read_slot();
+    if (!slot) {
         pd->lua->pushNil();
         return 1;
     }
 
-    // Return raw μ-law compressed data (no WAV header - server handles decoding)
-    pd->lua->pushBytes((char*)chunk_buffer, chunk_size);
+    // Return raw μ-law compressed data straight from the slot
+    // (no WAV header - server handles decoding)
+    pd->lua->pushBytes((char*)slot->data, slot->size);
+    pd->lua->pushInt(slot->sequence);
+    pd->lua->pushBytes((char*)slot->frame_map, slot->frame_map_count * sizeof(uint16_t));
+    pd->lua->pushInt(slot->overlap_frames);
+    last_chunk_sequence = slot->sequence;
 
-    // Cleanup chunk
-    pd->system->realloc(chunk_buffer, 0);
-    chunk_buffer = NULL;
-    chunk_size = 0;
-    chunk_ready = 0;
+    // Hand the slot back to the audio callback
+    ring_release();
 
-    return 1;
+    return 4;
 }
 
-// Lua function: mic.getChunkSequence() -> returns current chunk sequence number
+// Lua function: mic.getChunkSequence() -> returns sequence number of the last chunk retrieved
 static int mic_getChunkSequence(lua_State* L) {
-    pd->lua->pushInt(chunk_sequence);
+    pd->lua->pushInt(last_chunk_sequence);
     return 1;
 }
 
@@ -338,106 +992,282 @@ static int mic_setVADEnabled(lua_State* L) {
     return 1;
 }
 
-// Lua function: mic.getDuration() -> returns recording duration in seconds
-static int mic_getDuration(lua_State* L) {
-    if (!is_recording || !audio_buffer) {
-        pd->lua->pushFloat(0.0f);
+// Lua function: mic.setSampleRate(rate) -> select 8000 or 16000 Hz output (not while recording)
+static int mic_setSampleRate(lua_State* L) {
+    int rate = pd->lua->getArgInt(1);
+    if (is_recording || (rate != SAMPLE_RATE_OUTPUT && rate != SAMPLE_RATE_WIDE)) {
+        pd->lua->pushBool(0);
         return 1;
     }
-    pd->lua->pushFloat((float)buffer_position / (float)SAMPLE_RATE_OUTPUT);
+    output_rate = rate;
+    pd->lua->pushBool(1);
     return 1;
 }
 
-// Microphone callback - called by Playdate audio system
-// Processes: 44.1kHz input → 8kHz downsample → VAD filter → μ-law encode
-static int micCallback(void* context, int16_t* data, int len) {
-    (void)context;
+// Lua function: mic.getSampleRate() -> returns output sample rate in Hz
+static int mic_getSampleRate(lua_State* L) {
+    pd->lua->pushInt(output_rate);
+    return 1;
+}
 
-    if (!is_recording || !audio_buffer || !compressed_buffer) {
-        return 0;
+// Lua function: mic.setChunkDuration(seconds, [overlapMs]) -> chunk length (5-60s)
+// and optional overlap (0-500ms, whole 20ms frames) for the next recording
+static int mic_setChunkDuration(lua_State* L) {
+    int seconds = pd->lua->getArgInt(1);
+    int overlap = (pd->lua->getArgCount() >= 2 && !pd->lua->argIsNil(2)) ? pd->lua->getArgInt(2) : 0;
+    if (is_recording || seconds < CHUNK_DURATION_MIN || seconds > CHUNK_DURATION_MAX ||
+        overlap < 0 || overlap > CHUNK_OVERLAP_MAX_MS) {
+        pd->lua->pushBool(0);
+        return 1;
     }
+    chunk_duration = seconds;
+    chunk_overlap_ms = overlap - overlap % 20;
+    pd->lua->pushBool(1);
+    return 1;
+}
 
-    // Calculate level from this buffer (RMS)
-    float sum = 0;
-    for (int i = 0; i < len; i++) {
-        float sample = data[i] / 32768.0f;
-        sum += sample * sample;
+// Lua function: mic.getChunkDuration() -> returns chunk seconds and overlap ms
+static int mic_getChunkDuration(lua_State* L) {
+    pd->lua->pushInt(chunk_duration);
+    pd->lua->pushInt(chunk_overlap_ms);
+    return 2;
+}
+
+// Lua function: mic.setCodec(name) -> select "mulaw" or "adpcm" (not while recording)
+static int mic_setCodec(lua_State* L) {
+    const char* name = pd->lua->getArgString(1);
+    if (is_recording || !name) {
+        pd->lua->pushBool(0);
+        return 1;
+    }
+    for (int i = 0; i < CODEC_COUNT; i++) {
+        if (strcmp(name, codec_names[i]) == 0) {
+            codec = (Codec)i;
+            pd->lua->pushBool(1);
+            return 1;
+        }
     }
-    current_level = sqrtf(sum / (float)len);
+    pd->lua->pushBool(0);
+    return 1;
+}
 
-    // Downsample from 44.1kHz to 8kHz
-    for (int i = 0; i < len; i++) {
-        accumulated_samples += data[i];
-        sample_count++;
-        sample_accumulator += 1.0f;
+// Lua function: mic.getCodec() -> returns selected codec name
+static int mic_getCodec(lua_State* L) {
+    pd->lua->pushString(codec_names[codec]);
+    return 1;
+}
 
-        // Output a sample when we've accumulated enough
-        if (sample_accumulator >= DOWNSAMPLE_FACTOR) {
-            // Check if we need to grow the buffers
-            if (buffer_position >= buffer_size) {
-                size_t new_size = buffer_size + BUFFER_GROW_SAMPLES;
+// Lua function: mic.update() -> writes pending backup blocks to disk (call every frame)
+static int mic_update(lua_State* L) {
+    if (streaming_backup) {
+        backup_flush();
+    }
+    if (spool_enabled) {
+        spool_drain();
+    }
+    return 0;
+}
 
-                int16_t* new_buffer = (int16_t*)pd->system->realloc(audio_buffer, new_size * sizeof(int16_t));
-                if (!new_buffer) {
-                    return 0;  // Out of memory
-                }
-                audio_buffer = new_buffer;
+// Lua function: mic.poll() -> services the recorder like mic.update(), then
+// returns everything the recording screen needs per frame in one call:
+//   rms, peak, speech   - as mic.getLevels()
+//   duration            - seconds recorded
+//   pending             - chunks produced but not yet uploaded (ring + unacked spool)
+//   sequence            - highest chunk sequence spooled (or produced, without a spool)
+//   encodedBytes        - compressed bytes in published chunks
+//   droppedBytes        - what the frames the VAD skipped would have cost
+static int mic_poll(lua_State* L) {
+    mic_update(L);
+    mic_getLevels(L);
+
+    uint32_t pending = ring_load(&ring_head) - ring_tail + (uint32_t)spool_unacked;
+    int sequence = spool_enabled ? spool_last_sequence : chunk_sequence;
+    uint32_t dropped_samples = stat_frames_dropped * (uint32_t)vad_frame_size;
+    uint32_t dropped_bytes = codec == CODEC_ADPCM ? dropped_samples / 2 : dropped_samples;
+
+    pd->lua->pushFloat(is_recording ? (float)buffer_position / (float)output_rate : 0.0f);
+    pd->lua->pushInt((int)pending);
+    pd->lua->pushInt(sequence);
+    pd->lua->pushInt((int)stat_bytes_encoded);
+    pd->lua->pushInt((int)dropped_bytes);
+    return 8;
+}
 
-                uint8_t* new_compressed = (uint8_t*)pd->system->realloc(compressed_buffer, new_size);
-                if (!new_compressed) {
-                    return 0;  // Out of memory
-                }
-                compressed_buffer = new_compressed;
+// Lua function: mic.getSpooledSequence() -> returns highest chunk sequence on the
+// spool (chunks are numbered 1, 2, ... with no gaps) and the number not yet acked
+static int mic_getSpooledSequence(lua_State* L) {
+    pd->lua->pushInt(spool_last_sequence);
+    pd->lua->pushInt(spool_unacked);
+    return 2;
+}
 
-                buffer_size = new_size;
-            }
+// Lua function: mic.spoolRead(seq) -> returns upload body (frame map followed by
+// audio), frame map bytes and overlap frames for a spooled chunk, or nil
+static int mic_spoolRead(lua_State* L) {
+    SpoolEntry* entry = spool_find(pd->lua->getArgInt(1));
+    const SpoolRecord* record = entry ? spool_read(entry) : NULL;
+    if (!record) {
+        pd->lua->pushNil();
+        return 1;
+    }
+    pd->lua->pushBytes((const char*)spool_scratch + sizeof(SpoolRecord), entry->size);
+    pd->lua->pushInt((int)record->map_bytes);
+    pd->lua->pushInt(record->overlap_frames);
+    return 3;
+}
 
-            // Average the accumulated samples
-            int16_t output_sample = (int16_t)(accumulated_samples / sample_count);
+// Lua function: mic.spoolAck(seq) -> mark a chunk uploaded (the spool is
+// truncated once every chunk is acked)
+static int mic_spoolAck(lua_State* L) {
+    spool_ack(pd->lua->getArgInt(1));
+    return 0;
+}
 
-            // Store raw sample (for backup WAV)
-            audio_buffer[buffer_position] = output_sample;
+// Lua function: mic.spoolClose() -> close and delete the spool (session done)
+static int mic_spoolClose(lua_State* L) {
+    if (spool_write_errors > 0) {
+        pd->system->logToConsole("Spool lost %d chunk(s) to write errors", spool_write_errors);
+    }
+    spool_close(1);
+    return 0;
+}
 
-            // VAD: Add sample to frame buffer
-            vad_frame[vad_frame_pos % VAD_FRAME_SIZE] = output_sample;
-            vad_frame_pos++;
+// Lua function: mic.getStats() -> capture pipeline counters for the current (or
+// last) recording:
+//   callbacks, avgUs, minUs, maxUs  - micCallback count and duration
+//   chunksLost          - chunks lost to a full ring or failed spool writes
+//   framesLost          - speech frames dropped because the ring was full
+//   oomEvents           - in-memory backup filled the capture pool
+//   backupDropped       - backup samples lost because the disk fell behind
+//   framesKept, framesDropped - VAD decisions
+//   mulawBytes, adpcmBytes    - compressed bytes per codec since launch
+static int mic_getStats(lua_State* L) {
+    uint32_t avg_us = stat_callbacks ? (uint32_t)(stat_callback_us / stat_callbacks) : 0;
+    pd->lua->pushInt((int)stat_callbacks);
+    pd->lua->pushInt((int)avg_us);
+    pd->lua->pushInt((int)stat_callback_min_us);
+    pd->lua->pushInt((int)stat_callback_max_us);
+    pd->lua->pushInt(ring_overruns + spool_write_errors);
+    pd->lua->pushInt((int)stat_frames_lost);
+    pd->lua->pushInt((int)stat_oom_events);
+    pd->lua->pushInt((int)backup_samples_dropped);
+    pd->lua->pushInt((int)stat_frames_kept);
+    pd->lua->pushInt((int)stat_frames_dropped);
+    pd->lua->pushInt((int)stat_codec_bytes[CODEC_MULAW]);
+    pd->lua->pushInt((int)stat_codec_bytes[CODEC_ADPCM]);
+    return 12;
+}
 
-            // Apply VAD and μ-law encoding
-            if (!vad_enabled || frame_has_speech()) {
-                // Encode to μ-law and store in compressed buffer
-                compressed_buffer[compressed_position++] = mulaw_encode(output_sample);
-            }
-            // If VAD says silence, skip adding to compressed buffer (saves space!)
-
-            buffer_position++;
-            accumulated_samples = 0.0f;
-            sample_count = 0;
-            sample_accumulator -= DOWNSAMPLE_FACTOR;
-        }
-
-        // Check for chunk boundary (30 seconds of raw samples = time to create compressed chunk)
-        if (buffer_position > 0 && buffer_position % CHUNK_SAMPLES == 0 && !chunk_ready) {
-            // Create compressed chunk from the accumulated compressed data
-            // Note: compressed_position may be less than CHUNK_SAMPLES due to VAD filtering
-
-            chunk_size = compressed_position;
-            if (chunk_size > 0) {
-                chunk_buffer = (uint8_t*)pd->system->realloc(NULL, chunk_size);
-                if (chunk_buffer) {
-                    memcpy(chunk_buffer, compressed_buffer, chunk_size);
-                    chunk_ready = 1;
-                    chunk_sequence++;
-                }
-            }
+// Lua function: mic.setPoolSize(kb) -> replace the capture pool (256-8192 KB)
+// before recording; false while recording or spooling (its buffers live in the
+// pool), or if it can't be allocated (the old pool is kept)
+static int mic_setPoolSize(lua_State* L) {
+    int kb = pd->lua->getArgInt(1);
+    if (is_recording || spool_enabled || kb < MIC_POOL_KB_MIN || kb > MIC_POOL_KB_MAX) {
+        pd->lua->pushBool(0);
+        return 1;
+    }
+    pd->lua->pushBool(pool_alloc(kb));
+    return 1;
+}
 
-            // Reset compressed buffer for next chunk
-            compressed_position = 0;
+// Lua function: mic.getPoolSize() -> returns the capture pool's size and the
+// part carved for the current (or last) recording, in KB (the in-memory backup
+// takes the rest, so without a backup path the two are equal)
+static int mic_getPoolSize(lua_State* L) {
+    pd->lua->pushInt((int)(pool_size / 1024));
+    pd->lua->pushInt((int)((pool_used < pool_size ? pool_used : pool_size) / 1024));
+    return 2;
+}
+
+// Lua function: mic.getDuration() -> returns recording duration in seconds
+static int mic_getDuration(lua_State* L) {
+    if (!is_recording) {
+        pd->lua->pushFloat(0.0f);
+        return 1;
+    }
+    pd->lua->pushFloat((float)buffer_position / (float)output_rate);
+    return 1;
+}
+
+// Process one resampled sample: backup → VAD filter → encode → chunk
+// Returns 0 if the in-memory backup is full
+static inline int process_sample(int16_t output_sample) {
+    if (streaming_backup) {
+        // Store raw sample in the backup block ring (written to disk by mic.update)
+        backup_write(output_sample);
+    } else {
+        // Stop once the in-memory backup has filled the pool
+        if (buffer_position >= buffer_size) {
+            stat_oom_events++;
+            return 0;
+        }
+
+        // Store raw sample (for backup WAV)
+        audio_buffer[buffer_position] = output_sample;
+    }
+
+    buffer_position++;
+
+    // VAD: gate whole frames - encode the frame directly into the current ring
+    // slot if it has speech, otherwise skip it (saves space!)
+    if (vad_accumulate(&vad, output_sample)) {
+        int count = vad.frame_pos;
+        int keep = vad_decide(&vad) || !vad_enabled;
+        encode_frame(count, keep);
+
+        // Chunk boundary: a chunk's worth of recording time, or the slot can't
+        // hold another frame. Chunks hold whole frames and are usually much
+        // smaller than chunk_samples due to VAD
+        if (frame_map_frames >= chunk_frames ||
+            slot_position + vad_frame_size > ring_slot_capacity) {
+            encoder_publish();
         }
     }
 
     return 1;
 }
 
+// Microphone callback - called by Playdate audio system
+// Processes: 44.1kHz input → polyphase resample → VAD filter (+ level meter) → μ-law encode
+static int micCallback(void* context, int16_t* data, int len) {
+    (void)context;
+
+    if (!is_recording || (!streaming_backup && !audio_buffer)) {
+        return 0;
+    }
+
+    // Time the callback for mic.getStats(). The elapsed-time stopwatch is
+    // reset here (nothing else uses it) so the float keeps its precision
+    pd->system->resetElapsedTime();
+    int result = 1;
+
+    // Resample 44.1kHz → output rate one block at a time
+    for (int offset = 0; offset < len && result; offset += RS_BLOCK) {
+        int block = (len - offset < RS_BLOCK) ? len - offset : RS_BLOCK;
+        int produced = resample_block(&resampler, data + offset, block);
+
+        for (int i = 0; i < produced; i++) {
+            if (!process_sample(resampler.output[i])) {
+                result = 0;  // Pool full
+                break;
+            }
+        }
+    }
+
+    uint32_t elapsed_us = (uint32_t)(pd->system->getElapsedTime() * 1000000.0f);
+    if (stat_callbacks == 0 || elapsed_us < stat_callback_min_us) {
+        stat_callback_min_us = elapsed_us;
+    }
+    if (elapsed_us > stat_callback_max_us) {
+        stat_callback_max_us = elapsed_us;
+    }
+    stat_callback_us += elapsed_us;
+    stat_callbacks++;
+
+    return result;
+}
+
 // Create WAV header for given number of samples
 static void createWavHeader(WavHeader* header, size_t num_samples) {
     size_t data_size = num_samples * sizeof(int16_t);
@@ -449,9 +1279,9 @@ static void createWavHeader(WavHeader* header, size_t num_samples) {
     header->fmt_size = 16;
     header->audio_format = 1;  // PCM
     header->num_channels = 1;  // Mono
-    header->sample_rate = SAMPLE_RATE_OUTPUT;
+    header->sample_rate = output_rate;
     header->bits_per_sample = 16;
-    header->byte_rate = SAMPLE_RATE_OUTPUT * 1 * 2;  // sample_rate * channels * bytes_per_sample
+    header->byte_rate = output_rate * 1 * 2;  // sample_rate * channels * bytes_per_sample
     header->block_align = 1 * 2;  // channels * bytes_per_sample
     memcpy(header->data, "data", 4);
     header->data_size = (uint32_t)data_size;
@@ -467,8 +1297,13 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg) {
     if (event == kEventInitLua) {
         pd = playdate;
 
+        // Every recording buffer comes from this one block (see Capture Pool)
+        if (!pool_alloc(MIC_POOL_KB)) {
+            pd->system->logToConsole("Failed to allocate %d KB capture pool", MIC_POOL_KB);
+        }
+
         // Register mic as a global table with functions
-        // This matches the Lua stub pattern: mic.startRecording(), mic.getLevel(), etc.
+        // This matches the Lua stub pattern: mic.startRecording(), mic.getLevels(), etc.
         const char* err;
 
         if (!pd->lua->addFunction(mic_startRecording, "mic.startRecording", &err)) {
@@ -477,8 +1312,8 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg) {
         if (!pd->lua->addFunction(mic_stopRecording, "mic.stopRecording", &err)) {
             pd->system->logToConsole("Failed to register mic.stopRecording: %s", err);
         }
-        if (!pd->lua->addFunction(mic_getLevel, "mic.getLevel", &err)) {
-            pd->system->logToConsole("Failed to register mic.getLevel: %s", err);
+        if (!pd->lua->addFunction(mic_getLevels, "mic.getLevels", &err)) {
+            pd->system->logToConsole("Failed to register mic.getLevels: %s", err);
         }
         if (!pd->lua->addFunction(mic_isRecording, "mic.isRecording", &err)) {
             pd->system->logToConsole("Failed to register mic.isRecording: %s", err);
@@ -498,6 +1333,51 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg) {
         if (!pd->lua->addFunction(mic_setVADEnabled, "mic.setVADEnabled", &err)) {
             pd->system->logToConsole("Failed to register mic.setVADEnabled: %s", err);
         }
+        if (!pd->lua->addFunction(mic_setSampleRate, "mic.setSampleRate", &err)) {
+            pd->system->logToConsole("Failed to register mic.setSampleRate: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getSampleRate, "mic.getSampleRate", &err)) {
+            pd->system->logToConsole("Failed to register mic.getSampleRate: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_setCodec, "mic.setCodec", &err)) {
+            pd->system->logToConsole("Failed to register mic.setCodec: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getCodec, "mic.getCodec", &err)) {
+            pd->system->logToConsole("Failed to register mic.getCodec: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_setChunkDuration, "mic.setChunkDuration", &err)) {
+            pd->system->logToConsole("Failed to register mic.setChunkDuration: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getChunkDuration, "mic.getChunkDuration", &err)) {
+            pd->system->logToConsole("Failed to register mic.getChunkDuration: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_update, "mic.update", &err)) {
+            pd->system->logToConsole("Failed to register mic.update: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_poll, "mic.poll", &err)) {
+            pd->system->logToConsole("Failed to register mic.poll: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getStats, "mic.getStats", &err)) {
+            pd->system->logToConsole("Failed to register mic.getStats: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_setPoolSize, "mic.setPoolSize", &err)) {
+            pd->system->logToConsole("Failed to register mic.setPoolSize: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getPoolSize, "mic.getPoolSize", &err)) {
+            pd->system->logToConsole("Failed to register mic.getPoolSize: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_getSpooledSequence, "mic.getSpooledSequence", &err)) {
+            pd->system->logToConsole("Failed to register mic.getSpooledSequence: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_spoolRead, "mic.spoolRead", &err)) {
+            pd->system->logToConsole("Failed to register mic.spoolRead: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_spoolAck, "mic.spoolAck", &err)) {
+            pd->system->logToConsole("Failed to register mic.spoolAck: %s", err);
+        }
+        if (!pd->lua->addFunction(mic_spoolClose, "mic.spoolClose", &err)) {
+            pd->system->logToConsole("Failed to register mic.spoolClose: %s", err);
+        }
 
         pd->system->logToConsole("mic module loaded (C extension)");
     }
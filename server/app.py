@@ -1,50 +1,171 @@
 """
 CrankScribe Transcription Server
 
-Receives μ-law compressed audio chunks from Playdate, decodes them,
-and forwards to OpenAI Whisper API for transcription.
+Receives μ-law or IMA-ADPCM compressed audio chunks from Playdate, stores them
+compressed, and decodes each when forwarding it to OpenAI Whisper API for
+transcription (re-encoded in memory as FLAC, several times smaller than WAV).
+
+Chunks are transcribed in the background as they arrive, so finalize only has
+the last one left to do.
 
 Endpoints:
 - POST /chunk: Receive a compressed audio chunk
-- POST /finalize: Combine chunks and transcribe
-- POST /process: LLM processing (summary, minutes, todos)
+- GET /partial: Transcript text so far (for live display while recording)
+- GET /session/<id>/status: Chunks received so far (re-send only the gaps)
+- POST /finalize: Queue a job that transcribes the remaining chunk and stitches
+- POST /process: Queue an LLM processing job (summary, minutes, todos)
+- GET /job/<id>: Poll a queued job for its result
+- POST /notes/<id>: Apply a device's note delta (background backup)
+- GET /notes, GET /notes/<id>: A device's backed-up notes
 - GET /health: Health check
+- GET /metrics: Prometheus-style metrics (latency histograms, queue depth, sessions)
+
+Finalize and process return a job id straight away (202) and do the OpenAI
+calls on a bounded worker pool; when too many jobs are waiting they answer 429
+with Retry-After so devices back off instead of timing out.
 """
 
 import os
 import uuid
+import json
+import hashlib
+import hmac
 import audioop
-import tempfile
+import io
 import struct
-from datetime import datetime, timedelta
-from flask import Flask, request, jsonify
+import bisect
+import re
+import secrets
+import threading
+import time
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
+from flask import Flask, request, jsonify, g
 from flask_cors import CORS
 import openai
 
+import metrics
+from note_store import make_note_store
+from session_store import make_session_store
+
+try:
+    import soundfile  # FLAC encoder (libsndfile); without it audio goes as WAV
+except ImportError:
+    soundfile = None
+
 app = Flask(__name__)
 CORS(app)
 
 # Configuration
 OPENAI_API_KEY = os.environ.get("OPENAI_API_KEY")
-MAX_SESSION_AGE_MINUTES = 30
+OPENAI_STUB = os.environ.get("OPENAI_STUB") == "1"  # Offline Whisper/LLM stand-in for load tests
+MAX_SESSION_IDLE_MINUTES = 30  # Sessions expire this long after their last chunk/request
 INPUT_SAMPLE_RATE = 8000
 OUTPUT_SAMPLE_RATE = 16000
+VAD_FRAME_MS = 20             # Frame size the device's frame map counts in
+MAX_REINSERTED_GAP_MS = 500   # Longest silence put back where VAD dropped audio
+TRANSCRIBE_WORKERS = int(os.environ.get("TRANSCRIBE_WORKERS", 4))  # Chunks transcribed in the background at once
+PROMPT_TAIL_CHARS = 200       # Previous chunk's text passed as the Whisper prompt
+SHARD_TARGET_SECONDS = 120    # Audio per shard when finalize has a backlog of chunks
+SHARD_WORKERS = int(os.environ.get("SHARD_WORKERS", 4))       # Shards of one finalize transcribed at once
+JOB_WORKERS = int(os.environ.get("JOB_WORKERS", 4))            # Finalize/process jobs run at once
+MAX_PENDING_JOBS = int(os.environ.get("MAX_PENDING_JOBS", 16))  # Queued + running before 429
+JOB_TTL_SECONDS = 600         # Finished jobs are kept this long for polling
+RETRY_AFTER_SECONDS = 5       # Retry-After sent with a 429
+PROCESS_CACHE_SIZE = 256      # /process results kept, by transcript hash + action
+MAX_JOB_WAIT_SECONDS = 5      # Longest GET /job/<id>?wait= holds for new text
+NOTE_FIELDS = ("created_at", "duration_seconds", "transcript", "summary", "minutes", "todos")
+
+# Session storage (SESSION_STORE=memory|disk|redis, see session_store.py)
+store = make_session_store(MAX_SESSION_IDLE_MINUTES * 60)
+sessions_lock = threading.Lock()  # Guards the store against request and worker threads
+
+# Per-process transcription state: session_id -> {"worker", "finalizing"}
+active = {}
+
+# Note backups (NOTE_STORE=disk|memory|redis, see note_store.py), by X-Device-Id
+note_store = make_note_store()
+notes_lock = threading.Lock()  # Makes each delta's read-merge-write atomic
 
-# In-memory session storage (for demo; use Redis in production)
-sessions = {}
+# Background transcription: each session's chunks are transcribed in order, one
+# at a time (so each can be prompted with the previous chunk's text), while
+# different sessions share the pool
+transcribe_pool = ThreadPoolExecutor(max_workers=TRANSCRIBE_WORKERS)
+
+# Finalize/process jobs: job_id -> {"kind", "status", "result", "http_status", "partial", ...}
+# Status goes queued -> running -> done | error; the result is the JSON body
+# (and status code) the endpoint would have answered with synchronously, and
+# partial is text streamed so far (the first /process action)
+jobs = {}
+jobs_lock = threading.Lock()
+jobs_changed = threading.Condition(jobs_lock)  # Wakes long-polling GET /job/<id>
+current_job = threading.local()  # The job a job_pool thread is running
+job_pool = ThreadPoolExecutor(max_workers=JOB_WORKERS)
+
+# Finalize's backlog (chunks the background worker hadn't reached) is split
+# into shards that are transcribed in parallel
+shard_pool = ThreadPoolExecutor(max_workers=SHARD_WORKERS)
+
+# LLM results: (transcript sha256, action) -> text, least recently used first
+process_cache = OrderedDict()
+process_cache_lock = threading.Lock()
 
 # Initialize OpenAI client
 client = None
-if OPENAI_API_KEY:
+if OPENAI_STUB:
+    from stub_openai import StubClient
+    client = StubClient()
+elif OPENAI_API_KEY:
     client = openai.OpenAI(api_key=OPENAI_API_KEY)
 
+# Metrics (GET /metrics); gauges are read when scraped
+registry = metrics.Registry()
+request_seconds = registry.histogram(
+    "crankscribe_request_duration_seconds", "Request latency by endpoint", ("endpoint", "method"))
+requests_total = registry.counter(
+    "crankscribe_requests_total", "Requests answered, by endpoint and status", ("endpoint", "method", "status"))
+job_seconds = registry.histogram(
+    "crankscribe_job_duration_seconds", "Finalize/process job run time (excluding queueing)", ("kind",))
+job_wait_seconds = registry.histogram(
+    "crankscribe_job_queue_seconds", "Time jobs waited for a job worker", ("kind",))
+whisper_seconds = registry.histogram(
+    "crankscribe_whisper_duration_seconds", "Whisper API call latency", ("outcome",))
+transcriptions_in_flight = 0  # Background chunk transcriptions submitted and not finished (under sessions_lock)
+
+
+def job_counts():
+    with jobs_lock:
+        counts = {("queued",): 0, ("running",): 0}
+        for job in jobs.values():
+            if job["status"] in ("queued", "running"):
+                counts[(job["status"],)] += 1
+        return counts
+
+
+registry.gauge("crankscribe_active_sessions", "Sessions in the store", lambda: store.count())
+registry.gauge("crankscribe_jobs", "Finalize/process jobs waiting or running", job_counts, ("status",))
+registry.gauge("crankscribe_transcriptions_in_flight", "Background chunk transcriptions queued or running",
+               lambda: transcriptions_in_flight)
+registry.gauge("crankscribe_process_cache_entries", "Cached /process results", lambda: len(process_cache))
+registry.gauge("process_resident_memory_bytes", "Resident memory size in bytes", metrics.resident_memory_bytes)
+
 
 def cleanup_old_sessions():
-    """Remove sessions older than MAX_SESSION_AGE_MINUTES"""
-    cutoff = datetime.utcnow() - timedelta(minutes=MAX_SESSION_AGE_MINUTES)
-    expired = [sid for sid, data in sessions.items() if data["created"] < cutoff]
-    for sid in expired:
-        del sessions[sid]
+    """Remove sessions idle longer than MAX_SESSION_IDLE_MINUTES"""
+    with sessions_lock:
+        for sid in store.expire():
+            active.pop(sid, None)
+
+
+def active_state(session_id):
+    """This process's transcription state for a session (call with sessions_lock held)"""
+    return active.setdefault(session_id, {"worker": None, "finalizing": False})
+
+
+def load_chunk(session_id, seq):
+    """A stored chunk (compressed audio plus its info) as one dict"""
+    data, info = store.get_chunk(session_id, seq)
+    return dict(info, data=data)
 
 
 def decode_mulaw_to_pcm(mulaw_data):
@@ -54,11 +175,131 @@ def decode_mulaw_to_pcm(mulaw_data):
     return audioop.ulaw2lin(mulaw_data, 2)
 
 
-def resample_8k_to_16k(pcm_data):
-    """Resample from 8kHz to 16kHz (Whisper's expected rate)"""
+def decode_ima_adpcm_to_pcm(adpcm_data):
+    """Decode IMA-ADPCM audio to 16-bit PCM
+
+    Each chunk starts with a 4-byte header holding the encoder state
+    (int16 LE predictor, uint8 step index, reserved), followed by 4-bit
+    codes packed high nibble first.
+    """
+    predictor, index = check_ima_adpcm_header(adpcm_data)
+    pcm_data, _ = audioop.adpcm2lin(adpcm_data[4:], 2, (predictor, index))
+    return pcm_data
+
+
+def check_ima_adpcm_header(adpcm_data):
+    """Validate an IMA-ADPCM chunk's state header; returns (predictor, index)"""
+    if len(adpcm_data) < 4:
+        raise ValueError("ADPCM chunk too short")
+    predictor, index = struct.unpack("<hB", adpcm_data[:3])
+    if index > 88:
+        raise ValueError("Invalid ADPCM step index")
+    return predictor, index
+
+
+# Chunk decoders keyed by Content-Type
+DECODERS = {
+    "audio/mulaw": decode_mulaw_to_pcm,
+    "audio/x-ima-adpcm": decode_ima_adpcm_to_pcm,
+}
+
+
+def parse_frame_map(map_data):
+    """Parse a chunk's frame map: uint16 LE run lengths of VAD frames,
+    alternating kept, dropped, kept, ... (starting with kept)"""
+    if len(map_data) % 2:
+        raise ValueError("Frame map has odd length")
+    return list(struct.unpack(f"<{len(map_data) // 2}H", map_data))
+
+
+def decode_chunk(chunk):
+    """Decode a stored chunk's compressed audio to 16kHz 16-bit PCM"""
+    if not chunk["data"]:
+        return b""  # All silence
+    pcm = DECODERS[chunk["content_type"]](chunk["data"])
+    return resample_to_16k(pcm, chunk["sample_rate"])
+
+
+# Silence written at VAD gaps (sliced, never copied)
+SILENCE = memoryview(bytes(MAX_REINSERTED_GAP_MS * OUTPUT_SAMPLE_RATE * 2 // 1000))
+
+
+def write_chunk_timeline(chunk, orig_start_ms, out, keep_overlap=False):
+    """Decode a chunk and write its audio to out with short silences
+    reinserted at VAD gaps, and build a map from that audio's time back to
+    recording time.
+
+    Returns (audio_bytes, segments, duration_ms) where segments is a sorted
+    list of (sent_start, orig_start) pairs in seconds; time within a segment
+    advances at the same rate in both. duration_ms is the recording time it
+    covers (not counting a kept overlap).
+    """
+    bytes_per_ms = OUTPUT_SAMPLE_RATE * 2 // 1000
+    segments = []
+    sent_pos = 0             # Bytes of audio written so far
+    orig_ms = orig_start_ms  # Recording time so far
+
+    # Audio repeated from the previous chunk is already in its timeline, so
+    # it's skipped - unless asked to keep it (placed just before this chunk)
+    overlap = chunk["overlap_frames"] * VAD_FRAME_MS * bytes_per_ms
+    pcm = memoryview(decode_chunk(chunk))
+    if keep_overlap and overlap:
+        head = pcm[:overlap]
+        segments.append((0, (orig_start_ms - len(head) // bytes_per_ms) / 1000))
+        out.write(head)
+        sent_pos += len(head)
+    pcm = pcm[overlap:]
+    runs = chunk["frame_map"] or [len(pcm) // (bytes_per_ms * VAD_FRAME_MS)]
+    offset = 0
+    for i, frames in enumerate(runs):
+        run_ms = frames * VAD_FRAME_MS
+        if i % 2 == 0:
+            # Kept: take the run's audio (the last one may be a partial frame)
+            size = run_ms * bytes_per_ms if i < len(runs) - 1 else len(pcm) - offset
+            audio = pcm[offset:offset + size]
+            offset += size
+            run_ms = len(audio) // bytes_per_ms if i == len(runs) - 1 else run_ms
+        else:
+            # Dropped: put a short pause back so Whisper can segment
+            audio = SILENCE[:run_ms * bytes_per_ms]
+        if len(audio):
+            segments.append((sent_pos / (bytes_per_ms * 1000), orig_ms / 1000))
+            out.write(audio)
+            sent_pos += len(audio)
+        orig_ms += run_ms
+
+    return sent_pos, segments, orig_ms - orig_start_ms
+
+
+def write_timeline(chunks, orig_start_ms, out, keep_overlap=False):
+    """write_chunk_timeline for consecutive chunks sent as one stretch of
+    audio (keep_overlap applies to the first); same return values"""
+    audio_bytes, segments, duration_ms = 0, [], 0
+    for i, chunk in enumerate(chunks):
+        size, chunk_segments, chunk_ms = write_chunk_timeline(
+            chunk, orig_start_ms + duration_ms, out, keep_overlap and i == 0)
+        sent_s = audio_bytes / (OUTPUT_SAMPLE_RATE * 2)
+        segments += [(s + sent_s, o) for s, o in chunk_segments]
+        audio_bytes += size
+        duration_ms += chunk_ms
+    return audio_bytes, segments, duration_ms
+
+
+def to_recording_time(segments, t):
+    """Map a time in the audio sent to Whisper back to recording time"""
+    starts = [s for s, _ in segments]
+    i = max(bisect.bisect_right(starts, t) - 1, 0)
+    sent_start, orig_start = segments[i]
+    return round(orig_start + (t - sent_start), 2)
+
+
+def resample_to_16k(pcm_data, input_rate=INPUT_SAMPLE_RATE):
+    """Resample to 16kHz (Whisper's expected rate)"""
+    if input_rate == OUTPUT_SAMPLE_RATE:
+        return pcm_data
     # audioop.ratecv handles resampling
     # (data, width, nchannels, inrate, outrate, state)
-    resampled, _ = audioop.ratecv(pcm_data, 2, 1, INPUT_SAMPLE_RATE, OUTPUT_SAMPLE_RATE, None)
+    resampled, _ = audioop.ratecv(pcm_data, 2, 1, input_rate, OUTPUT_SAMPLE_RATE, None)
     return resampled
 
 
@@ -86,29 +327,334 @@ def create_wav_header(data_size, sample_rate=16000, bits_per_sample=16, num_chan
     return header
 
 
-def transcribe_audio(wav_data):
-    """Send audio to OpenAI Whisper API"""
+def encode_audio(pcm):
+    """Encode 16 kHz mono 16-bit PCM for upload to Whisper, in memory
+
+    Returns the (filename, bytes) pair the OpenAI client takes as a file:
+    FLAC when soundfile is installed, else WAV.
+    """
+    if soundfile:
+        out = io.BytesIO()
+        with soundfile.SoundFile(out, "w", samplerate=OUTPUT_SAMPLE_RATE, channels=1,
+                                 subtype="PCM_16", format="FLAC") as f:
+            f.buffer_write(pcm, dtype="int16")
+        return "audio.flac", out.getvalue()
+    return "audio.wav", create_wav_header(len(pcm)) + bytes(pcm)
+
+
+def transcribe_audio(audio_file, word_timestamps=False, prompt=None):
+    """Send audio (a (filename, bytes) pair from encode_audio) to OpenAI Whisper API
+
+    Returns the transcript text, or with word_timestamps the verbose
+    response (text plus per-word start/end times). prompt carries preceding
+    text so Whisper keeps continuity across chunks.
+    """
     if not client:
         return None, "OpenAI API key not configured"
 
-    # Write to temp file (OpenAI API needs a file)
-    with tempfile.NamedTemporaryFile(suffix=".wav", delete=False) as f:
-        f.write(wav_data)
-        temp_path = f.name
-
+    started = time.monotonic()
     try:
-        with open(temp_path, "rb") as audio_file:
-            result = client.audio.transcriptions.create(
-                model="whisper-1",
-                file=audio_file,
-                response_format="text",
-                language="en"
-            )
+        result = client.audio.transcriptions.create(
+            model="whisper-1",
+            file=audio_file,
+            response_format="verbose_json" if word_timestamps else "text",
+            timestamp_granularities=["word"] if word_timestamps else None,
+            prompt=prompt or None,
+            language="en"
+        )
+        whisper_seconds.observe(time.monotonic() - started, outcome="ok")
         return result, None
     except Exception as e:
+        whisper_seconds.observe(time.monotonic() - started, outcome="error")
         return None, str(e)
-    finally:
-        os.unlink(temp_path)
+
+
+def prepare_audio(chunks, orig_start_ms, keep_overlap=False):
+    """Decode chunks' timeline into memory for Whisper
+
+    Returns a dict of the pcm, audio_bytes, segments and duration_ms (see
+    write_chunk_timeline); transcribe_prepared encodes and sends it.
+    """
+    out = io.BytesIO()
+    audio_bytes, segments, duration_ms = write_timeline(chunks, orig_start_ms, out, keep_overlap)
+    return {"pcm": out.getbuffer(), "audio_bytes": audio_bytes, "segments": segments,
+            "duration_ms": duration_ms}
+
+
+def transcribe_prepared(audio, prompt):
+    """Transcribe audio from prepare_audio; returns (transcript, error)
+
+    transcript holds the text, words in recording time, and the seconds of
+    audio sent and recording covered.
+    """
+    segments = audio["segments"]
+    transcript = {"text": "", "words": [], "audio_seconds": audio["audio_bytes"] / (OUTPUT_SAMPLE_RATE * 2),
+                  "duration_ms": audio["duration_ms"]}
+    if not audio["audio_bytes"]:
+        return transcript, None  # All silence
+    # Encoding here (not in prepare_audio) runs it on the shard's worker
+    result, error = transcribe_audio(encode_audio(audio["pcm"]), word_timestamps=True, prompt=prompt)
+    if error:
+        return None, error
+
+    transcript["text"] = result.text.strip()
+    transcript["words"] = [
+        {
+            "word": w.word,
+            "start": to_recording_time(segments, w.start),
+            "end": to_recording_time(segments, w.end)
+        }
+        for w in (result.words or [])
+    ]
+    return transcript, None
+
+
+def transcribe_chunk(chunk, orig_start_ms, prompt):
+    """Transcribe one chunk; returns (transcript, error)"""
+    return transcribe_prepared(prepare_audio([chunk], orig_start_ms), prompt)
+
+
+def chunk_audio_ms(chunk):
+    """Kept audio in a chunk, from its frame map (or size) without decoding"""
+    runs = chunk["frame_map"]
+    if runs:
+        return sum(runs[0::2]) * VAD_FRAME_MS
+    samples = len(chunk["data"]) if chunk["content_type"] == "audio/mulaw" else len(chunk["data"]) * 2
+    return samples * 1000 // chunk["sample_rate"]
+
+
+def ends_in_silence(chunk):
+    """Whether a chunk's frame map ends with a dropped (VAD silent) run"""
+    runs = chunk["frame_map"]
+    return bool(runs) and len(runs) % 2 == 0 and runs[-1] > 0
+
+
+def plan_shards(chunks):
+    """Group consecutive (seq, chunk) pairs into shards of about
+    SHARD_TARGET_SECONDS of audio
+
+    Once a shard reaches the target it ends at the next chunk that ends in
+    silence, so cuts fall in pauses; at twice the target it's cut anyway and
+    the next shard keeps the overlap, so the word spanning the cut is heard
+    whole. Returns a list of (pairs, keep_overlap).
+    """
+    target_ms = SHARD_TARGET_SECONDS * 1000
+    shards = []
+    current, current_ms, keep_overlap = [], 0, False
+    for seq, chunk in chunks:
+        current.append((seq, chunk))
+        current_ms += chunk_audio_ms(chunk)
+        silent_cut = ends_in_silence(chunk)
+        if (current_ms >= target_ms and silent_cut) or current_ms >= 2 * target_ms:
+            shards.append((current, keep_overlap))
+            current, current_ms, keep_overlap = [], 0, not silent_cut
+    if current:
+        shards.append((current, keep_overlap))
+    return shards
+
+
+def drop_repeated_words(previous, transcript):
+    """De-duplicate a shard that kept its overlap: drop its leading words
+    the previous shard already has (centred before that shard's last word
+    ended), from both the words list and the text"""
+    if not previous or not previous["words"] or not transcript["words"]:
+        return
+    boundary = previous["words"][-1]["end"]
+    repeated = 0
+    for w in transcript["words"]:
+        if (w["start"] + w["end"]) / 2 >= boundary:
+            break
+        repeated += 1
+    if repeated:
+        transcript["words"] = transcript["words"][repeated:]
+        transcript["text"] = " ".join(transcript["text"].split()[repeated:])
+
+
+def transcribe_backlog(session_id, seqs):
+    """Transcribe the chunks finalize found untranscribed: shards are
+    written in order (to fix their recording times) then sent to Whisper in
+    parallel, and stored in order. Returns an error, or None."""
+    orig_ms = store.get_meta(session_id).get("orig_ms", 0)
+    prompt = prompt_for(session_id)
+    shards = []
+    for pairs, keep_overlap in plan_shards([(seq, load_chunk(session_id, seq)) for seq in seqs]):
+        audio = prepare_audio([chunk for _, chunk in pairs], orig_ms, keep_overlap)
+        orig_ms += audio["duration_ms"]
+        # Only the first shard follows text we have; the rest run alongside it
+        future = shard_pool.submit(transcribe_prepared, audio, prompt if not shards else None)
+        shards.append(([seq for seq, _ in pairs], keep_overlap, future))
+
+    # Stitch in order; after a failure, keep what came before it (so a retry
+    # resumes there) and let the rest finish unused
+    error = None
+    previous = None
+    for shard_seqs, keep_overlap, future in shards:
+        transcript, shard_error = future.result()
+        if error:
+            continue
+        if shard_error:
+            error = shard_error
+            continue
+        if keep_overlap:
+            drop_repeated_words(previous, transcript)
+        previous = transcript
+        with sessions_lock:
+            # The shard's transcript goes under its first chunk; the others
+            # are marked done with nothing of their own
+            store_transcript(session_id, shard_seqs[0], transcript)
+            for seq in shard_seqs[1:]:
+                store_transcript(session_id, seq, {"text": "", "words": [], "audio_seconds": 0,
+                                                   "duration_ms": 0})
+    return error
+
+
+def next_chunk_to_transcribe(session_id):
+    """Sequence number of the session's next chunk in order, if it has arrived"""
+    transcripts = store.get_transcripts(session_id)
+    pending = [k for k in store.chunk_seqs(session_id) if k not in transcripts]
+    if not pending:
+        return None
+    seq = pending[0]
+    # Chunks go in order so recording time and prompts carry over; a gap
+    # (chunk still uploading) waits
+    last = store.get_meta(session_id).get("last_transcribed")
+    if last is not None and seq != last + 1:
+        return None
+    return seq
+
+
+def prompt_for(session_id):
+    """Tail of the text transcribed so far, for Whisper's prompt"""
+    transcripts = store.get_transcripts(session_id)
+    text = " ".join(t["text"] for _, t in sorted(transcripts.items()) if t["text"])
+    return text[-PROMPT_TAIL_CHARS:]
+
+
+def schedule_transcription(session_id):
+    """Start transcribing the session's next chunk if none is in flight
+    (call with sessions_lock held)"""
+    state = active_state(session_id)
+    if not store.exists(session_id) or state["worker"] or state["finalizing"]:
+        return
+    seq = next_chunk_to_transcribe(session_id)
+    if seq is None:
+        return
+    global transcriptions_in_flight
+    transcriptions_in_flight += 1
+    state["worker"] = transcribe_pool.submit(
+        transcription_worker, session_id, seq, load_chunk(session_id, seq),
+        store.get_meta(session_id).get("orig_ms", 0), prompt_for(session_id))
+
+
+def transcription_worker(session_id, seq, chunk, orig_start_ms, prompt):
+    """Background job: transcribe one chunk and queue the next"""
+    global transcriptions_in_flight
+    transcript, error = transcribe_chunk(chunk, orig_start_ms, prompt)
+    with sessions_lock:
+        transcriptions_in_flight -= 1
+        active_state(session_id)["worker"] = None
+        if not store.exists(session_id):
+            active.pop(session_id, None)
+            return  # Expired or cancelled meanwhile
+        if error:
+            # Leave it pending; /finalize retries
+            print(f"Background transcription of chunk {seq} failed: {error}")
+            store.update_meta(session_id, error=error)
+            return
+        store_transcript(session_id, seq, transcript)
+        schedule_transcription(session_id)
+
+
+def store_transcript(session_id, seq, transcript):
+    """Record a chunk's transcript and advance the session's recording time"""
+    store.set_transcript(session_id, seq, transcript)
+    meta = store.get_meta(session_id)
+    store.update_meta(session_id, last_transcribed=seq,
+                      orig_ms=meta.get("orig_ms", 0) + transcript["duration_ms"])
+
+
+def expire_jobs():
+    """Forget finished jobs nobody has polled for JOB_TTL_SECONDS (call with jobs_lock held)"""
+    cutoff = time.time() - JOB_TTL_SECONDS
+    for job_id in [k for k, j in jobs.items() if j.get("finished", time.time()) < cutoff]:
+        del jobs[job_id]
+
+
+def pending_job_count():
+    """Jobs queued or running (call with jobs_lock held)"""
+    return sum(1 for j in jobs.values() if j["status"] in ("queued", "running"))
+
+
+def submit_job(kind, fn, *args):
+    """Queue fn(*args) -> (body, http_status) on the job pool.
+    Returns the job id, or None when MAX_PENDING_JOBS are already waiting."""
+    with jobs_lock:
+        expire_jobs()
+        if pending_job_count() >= MAX_PENDING_JOBS:
+            return None
+        job_id = str(uuid.uuid4())
+        jobs[job_id] = {"kind": kind, "status": "queued", "result": None,
+                        "http_status": None, "partial": "", "created": time.time()}
+    job_pool.submit(run_job, job_id, fn, args)
+    return job_id
+
+
+def run_job(job_id, fn, args):
+    with jobs_lock:
+        job = jobs[job_id]
+        job["status"] = "running"
+    started = time.time()
+    job_wait_seconds.observe(started - job["created"], kind=job["kind"])
+    current_job.id = job_id
+    try:
+        body, http_status = fn(*args)
+    except Exception as e:
+        body, http_status = {"error": str(e)}, 500
+    job_seconds.observe(time.time() - started, kind=job["kind"])
+    with jobs_changed:
+        jobs[job_id].update(status="done" if http_status == 200 else "error",
+                            result=body, http_status=http_status, finished=time.time())
+        jobs_changed.notify_all()
+
+
+def report_partial(text):
+    """From inside a job: publish the text streamed so far"""
+    with jobs_changed:
+        jobs[current_job.id]["partial"] = text
+        jobs_changed.notify_all()
+
+
+def busy_response():
+    """429 telling the device when to try again"""
+    response = jsonify({"error": "Server busy", "retry_after": RETRY_AFTER_SECONDS})
+    response.status_code = 429
+    response.headers["Retry-After"] = str(RETRY_AFTER_SECONDS)
+    return response
+
+
+def job_accepted(job_id):
+    return jsonify({"job_id": job_id, "status": "queued"}), 202, {"Location": f"/job/{job_id}"}
+
+
+@app.before_request
+def start_timer():
+    g.request_started = time.monotonic()
+
+
+@app.after_request
+def record_request(response):
+    # Label by route pattern (/job/<job_id>), not path, to keep label sets bounded
+    endpoint = request.url_rule.rule if request.url_rule else "unmatched"
+    if endpoint != "/metrics":
+        request_seconds.observe(time.monotonic() - g.request_started, endpoint=endpoint, method=request.method)
+        requests_total.inc(endpoint=endpoint, method=request.method, status=response.status_code)
+    return response
+
+
+@app.route("/metrics", methods=["GET"])
+def metrics_endpoint():
+    """Prometheus text exposition of the registry above"""
+    return registry.render(), 200, {"Content-Type": "text/plain; version=0.0.4; charset=utf-8"}
 
 
 @app.route("/health", methods=["GET"])
@@ -116,8 +662,10 @@ def health():
     """Health check endpoint"""
     return jsonify({
         "status": "ok",
-        "openai_configured": OPENAI_API_KEY is not None,
-        "active_sessions": len(sessions)
+        "openai_configured": client is not None,
+        "openai_stub": OPENAI_STUB,
+        "active_sessions": store.count(),
+        "pending_jobs": pending_job_count()
     })
 
 
@@ -128,6 +676,7 @@ def receive_chunk():
 
     session_id = request.headers.get("X-Session-Id")
     chunk_seq = request.headers.get("X-Chunk-Seq")
+    sample_rate = request.headers.get("X-Sample-Rate")
 
     if not session_id:
         return jsonify({"error": "Missing X-Session-Id header"}), 400
@@ -137,97 +686,200 @@ def receive_chunk():
     except ValueError:
         return jsonify({"error": "Invalid X-Chunk-Seq"}), 400
 
-    # Get μ-law compressed data
-    mulaw_data = request.data
-    if not mulaw_data:
-        return jsonify({"error": "No audio data received"}), 400
+    try:
+        sample_rate = int(sample_rate) if sample_rate else INPUT_SAMPLE_RATE
+    except ValueError:
+        return jsonify({"error": "Invalid X-Sample-Rate"}), 400
 
-    # Decode μ-law to PCM
-    pcm_data = decode_mulaw_to_pcm(mulaw_data)
+    if sample_rate not in (INPUT_SAMPLE_RATE, OUTPUT_SAMPLE_RATE):
+        return jsonify({"error": f"Unsupported sample rate: {sample_rate}"}), 400
 
-    # Resample 8kHz → 16kHz
-    pcm_16k = resample_8k_to_16k(pcm_data)
+    # Pick decoder from Content-Type (devices predating codec selection send audio/mulaw)
+    content_type = request.mimetype or "audio/mulaw"
+    decoder = DECODERS.get(content_type)
+    if not decoder:
+        return jsonify({"error": f"Unsupported Content-Type: {content_type}"}), 415
 
-    # Store in session
-    if session_id not in sessions:
-        sessions[session_id] = {
-            "chunks": {},
-            "created": datetime.utcnow()
-        }
+    try:
+        map_bytes = int(request.headers.get("X-Frame-Map-Bytes") or 0)
+    except ValueError:
+        return jsonify({"error": "Invalid X-Frame-Map-Bytes"}), 400
+
+    try:
+        overlap_frames = max(int(request.headers.get("X-Overlap-Frames") or 0), 0)
+    except ValueError:
+        return jsonify({"error": "Invalid X-Overlap-Frames"}), 400
+
+    # Body is the frame map (if any) followed by the compressed audio
+    body = request.data
+    if map_bytes < 0 or map_bytes > len(body):
+        return jsonify({"error": "Invalid X-Frame-Map-Bytes"}), 400
+    compressed_data = body[map_bytes:]
+
+    # All-silence chunks carry only a frame map (no audio) to keep timing
+    if not compressed_data and not map_bytes:
+        return jsonify({"error": "No audio data received"}), 400
+
+    # Check the chunk parses, but keep it compressed: it's decoded (and
+    # resampled to 16kHz) only when transcribed, so sessions hold 2-4x less
+    try:
+        frame_map = parse_frame_map(body[:map_bytes]) if map_bytes else None
+        if compressed_data and decoder is decode_ima_adpcm_to_pcm:
+            check_ima_adpcm_header(compressed_data)
+    except ValueError as e:
+        return jsonify({"error": str(e)}), 400
 
-    sessions[session_id]["chunks"][chunk_seq] = pcm_16k
+    # Store in session (a re-sent chunk is acked without being stored again)
+    # and transcribe in the background
+    with sessions_lock:
+        stored = store.add_chunk(session_id, chunk_seq, compressed_data, {
+            "content_type": content_type,
+            "sample_rate": sample_rate,
+            "frame_map": frame_map,
+            "overlap_frames": overlap_frames
+        })
+        if stored:
+            schedule_transcription(session_id)
 
     return jsonify({
         "received": chunk_seq,
-        "size_bytes": len(mulaw_data),
-        "decoded_bytes": len(pcm_16k)
+        "duplicate": not stored,
+        "size_bytes": len(compressed_data)
+    })
+
+
+@app.route("/partial", methods=["GET"])
+def partial_transcript():
+    """Text transcribed since a cursor, while the session is still recording
+
+    The cursor counts transcribed chunks; pass back the returned cursor to
+    get only new text next time.
+    """
+    session_id = request.headers.get("X-Session-Id")
+    if not session_id:
+        return jsonify({"error": "Missing X-Session-Id header"}), 400
+
+    try:
+        cursor = max(int(request.args.get("cursor", 0)), 0)
+    except ValueError:
+        return jsonify({"error": "Invalid cursor"}), 400
+
+    with sessions_lock:
+        if not store.exists(session_id):
+            return jsonify({"error": "Session not found"}), 404
+        store.touch(session_id)
+        transcripts = store.get_transcripts(session_id)
+        ordered = [transcripts[k] for k in sorted(transcripts)]
+        chunks_received = len(store.chunk_seqs(session_id))
+
+    return jsonify({
+        "text": " ".join(t["text"] for t in ordered[cursor:] if t["text"]),
+        "cursor": len(ordered),
+        "chunks_received": chunks_received
+    })
+
+
+@app.route("/session/<session_id>/status", methods=["GET"])
+def session_status(session_id):
+    """Which chunks the server has, so a device re-sends only the gaps"""
+    cleanup_old_sessions()
+
+    with sessions_lock:
+        if not store.exists(session_id):
+            return jsonify({"error": "Session not found"}), 404
+        store.touch(session_id)
+        acked = store.chunk_seqs(session_id)
+        transcribed = sorted(store.get_transcripts(session_id))
+        meta = store.get_meta(session_id)
+
+    return jsonify({
+        "session_id": session_id,
+        "acked": acked,
+        "transcribed": transcribed,
+        "error": meta.get("error"),
+        "expires_in_seconds": MAX_SESSION_IDLE_MINUTES * 60
     })
 
 
 @app.route("/finalize", methods=["POST"])
 def finalize_session():
-    """Combine all chunks and transcribe"""
+    """Queue the session's finalize job; poll GET /job/<id> for the transcript"""
     session_id = request.headers.get("X-Session-Id")
 
     if not session_id:
         return jsonify({"error": "Missing X-Session-Id header"}), 400
 
-    if session_id not in sessions:
-        return jsonify({"error": "Session not found"}), 404
+    with sessions_lock:
+        if not store.exists(session_id):
+            return jsonify({"error": "Session not found"}), 404
+        if not store.chunk_seqs(session_id):
+            store.delete(session_id)
+            return jsonify({"error": "No chunks in session"}), 400
+        store.touch(session_id)
+        state = active_state(session_id)
+        # A re-sent finalize (e.g. the 202 was lost) gets the job already running
+        if state.get("finalize_job"):
+            return job_accepted(state["finalize_job"])
 
-    session = sessions[session_id]
-    chunks = session["chunks"]
+        job_id = submit_job("finalize", run_finalize, session_id)
+        if not job_id:
+            return busy_response()
+        # Stop queueing background work; at most one job is still in flight
+        state["finalizing"] = True
+        state["finalize_job"] = job_id
 
-    if not chunks:
-        del sessions[session_id]
-        return jsonify({"error": "No chunks in session"}), 400
+    return job_accepted(job_id)
 
-    # Combine chunks in order
-    ordered_keys = sorted(chunks.keys())
-    full_audio = b"".join(chunks[k] for k in ordered_keys)
 
-    # Create WAV file
-    wav_header = create_wav_header(len(full_audio))
-    wav_data = wav_header + full_audio
+def run_finalize(session_id):
+    """Transcribe whatever chunks are left (usually just the last) and stitch"""
+    with sessions_lock:
+        worker = active_state(session_id)["worker"]
 
-    # Transcribe
-    transcript, error = transcribe_audio(wav_data)
-
-    # Cleanup session
-    del sessions[session_id]
+    if worker:
+        worker.result()
 
+    # Remaining chunks in order (any gaps are skipped over rather than waited
+    # for); a long backlog is sharded and transcribed in parallel
+    transcripts = store.get_transcripts(session_id)
+    pending = [k for k in store.chunk_seqs(session_id) if k not in transcripts]
+    error = transcribe_backlog(session_id, pending) if pending else None
     if error:
-        return jsonify({"error": error}), 500
-
-    return jsonify({
-        "transcript": transcript,
-        "chunks_combined": len(ordered_keys),
-        "audio_duration_seconds": len(full_audio) / (OUTPUT_SAMPLE_RATE * 2)
-    })
+        # Keep the session (and what's transcribed) so finalize can be retried
+        with sessions_lock:
+            state = active_state(session_id)
+            state["finalizing"] = False
+            state["finalize_job"] = None
+            schedule_transcription(session_id)
+        return {"error": error}, 500
 
+    transcripts = store.get_transcripts(session_id)
+    meta = store.get_meta(session_id)
 
-@app.route("/process", methods=["POST"])
-def process_transcript():
-    """Process transcript with LLM (summary, minutes, todos)"""
-    if not client:
-        return jsonify({"error": "OpenAI API key not configured"}), 500
+    # Cleanup session
+    with sessions_lock:
+        store.delete(session_id)
+        active.pop(session_id, None)
 
-    data = request.json
-    if not data:
-        return jsonify({"error": "No JSON data"}), 400
+    ordered = [transcripts[k] for k in sorted(transcripts)]
+    if not any(t["audio_seconds"] for t in ordered):
+        return {"error": "No speech in session"}, 400
 
-    action = data.get("action")
-    text = data.get("text")
+    return {
+        "transcript": " ".join(t["text"] for t in ordered if t["text"]),
+        "words": [w for t in ordered for w in t["words"]],
+        "chunks_combined": len(ordered),
+        "audio_duration_seconds": sum(t["audio_seconds"] for t in ordered),
+        "recording_duration_seconds": meta.get("orig_ms", 0) / 1000
+    }, 200
 
-    if not action or not text:
-        return jsonify({"error": "Missing action or text"}), 400
 
-    prompts = {
-        "summary": """Summarize the key points from this transcript in 3-5 bullet points.
+PROCESS_PROMPTS = {
+    "summary": """Summarize the key points from this transcript in 3-5 bullet points.
 Be concise - each point should be one line.
 Focus on the most important information.""",
 
-        "minutes": """Convert this transcript into formal meeting minutes with the following sections:
+    "minutes": """Convert this transcript into formal meeting minutes with the following sections:
 - **Attendees** (if mentioned)
 - **Discussion Points**
 - **Decisions Made**
@@ -235,28 +887,325 @@ Focus on the most important information.""",
 
 Be concise and professional. Format for easy reading on a small screen.""",
 
-        "todos": """Extract actionable to-do items from this transcript.
+    "todos": """Extract actionable to-do items from this transcript.
 Format as a checklist with [ ] for each item.
 Include who is responsible if mentioned.
 Only include clear, actionable tasks."""
+}
+
+
+def cached_results(key, actions):
+    """The actions already in the process cache, as action -> text"""
+    results = {}
+    with process_cache_lock:
+        for action in actions:
+            if (key, action) in process_cache:
+                process_cache.move_to_end((key, action))
+                results[action] = process_cache[(key, action)]
+    return results
+
+
+def cache_results(key, results):
+    with process_cache_lock:
+        for action, text in results.items():
+            process_cache[(key, action)] = text
+        while len(process_cache) > PROCESS_CACHE_SIZE:
+            process_cache.popitem(last=False)
+
+
+def process_response(actions, results, cached):
+    """/process body: every action's text, plus the first's as "result" (the
+    single-action form)"""
+    return {
+        "result": results[actions[0]],
+        "results": {action: results[action] for action in actions},
+        "cached": [action for action in actions if action in cached]
     }
 
-    if action not in prompts:
-        return jsonify({"error": f"Unknown action: {action}"}), 400
 
+@app.route("/process", methods=["POST"])
+def process_transcript():
+    """LLM processing (summary, minutes, todos)
+
+    Takes one "action" or a list of "actions"; several missing from the
+    cache are produced by a single structured-output call. Answers at once
+    when every action is cached, otherwise queues a job to poll with
+    GET /job/<id>.
+    """
+    if not client:
+        return jsonify({"error": "OpenAI API key not configured"}), 500
+
+    data = request.json
+    if not data:
+        return jsonify({"error": "No JSON data"}), 400
+
+    actions = data.get("actions") or ([data["action"]] if data.get("action") else [])
+    text = data.get("text")
+
+    if not actions or not text or not isinstance(actions, list):
+        return jsonify({"error": "Missing action or text"}), 400
+
+    actions = list(dict.fromkeys(actions))  # Drop repeats, keep order
+    for action in actions:
+        if action not in PROCESS_PROMPTS:
+            return jsonify({"error": f"Unknown action: {action}"}), 400
+
+    key = hashlib.sha256(text.encode("utf-8")).hexdigest()
+    cached = cached_results(key, actions)
+    if len(cached) == len(actions):
+        return jsonify(process_response(actions, cached, cached))
+
+    job_id = submit_job("process", run_process, key, text, actions, cached)
+    if not job_id:
+        return busy_response()
+    return job_accepted(job_id)
+
+
+def streamed_field(output, name):
+    """The value so far of a string field in JSON output still being
+    streamed (only as far as it can be decoded)"""
+    match = re.search(r'"%s"\s*:\s*"' % re.escape(name), output)
+    if not match:
+        return ""
+    raw = output[match.end():]
+    i = 0
+    while i < len(raw) and raw[i] != '"':
+        if raw[i] == "\\":
+            step = 6 if raw[i + 1:i + 2] == "u" else 2
+            if i + step > len(raw):
+                break  # Escape not complete yet
+            i += step
+        else:
+            i += 1
+    return json.loads('"' + raw[:i] + '"')
+
+
+def stream_completion(stream, partial=lambda output: output):
+    """Read a streamed chat completion, publishing partial(output so far)
+    as the job's partial text; returns the whole output"""
+    output = ""
+    for event in stream:
+        delta = event.choices[0].delta.content if event.choices else None
+        if delta:
+            output += delta
+            report_partial(partial(output))
+    return output
+
+
+def run_process(key, text, actions, cached):
+    """Produce the actions missing from cached in one LLM call and cache them
+
+    The call is streamed; the first action's text is published as it
+    arrives so the device can show it before the call finishes.
+    """
+    missing = [action for action in actions if action not in cached]
+    streamed = actions[0] in missing
     try:
-        response = client.chat.completions.create(
-            model="gpt-4o-mini",
-            messages=[
-                {"role": "system", "content": "You are a concise note-taking assistant for a tiny screen device."},
-                {"role": "user", "content": prompts[action] + "\n\nTranscript:\n" + text}
-            ],
-            max_tokens=500
-        )
-        result = response.choices[0].message.content
-        return jsonify({"result": result})
+        if len(missing) == 1:
+            stream = client.chat.completions.create(
+                model="gpt-4o-mini",
+                messages=[
+                    {"role": "system", "content": "You are a concise note-taking assistant for a tiny screen device."},
+                    {"role": "user", "content": PROCESS_PROMPTS[missing[0]] + "\n\nTranscript:\n" + text}
+                ],
+                max_tokens=500,
+                stream=True
+            )
+            results = {missing[0]: stream_completion(stream) if streamed else
+                       stream_completion(stream, lambda output: "")}
+        else:
+            # One call, one field per action, so the transcript's prompt
+            # tokens are paid once
+            instructions = "\n\n".join(f"## {action}\n{PROCESS_PROMPTS[action]}" for action in missing)
+            stream = client.chat.completions.create(
+                model="gpt-4o-mini",
+                messages=[
+                    {"role": "system", "content": "You are a concise note-taking assistant for a tiny screen device."},
+                    {"role": "user", "content": "Write each of the following for the transcript, "
+                                                "in the JSON field of the same name:\n\n"
+                                                + instructions + "\n\nTranscript:\n" + text}
+                ],
+                response_format={"type": "json_schema", "json_schema": {
+                    "name": "notes",
+                    "strict": True,
+                    "schema": {
+                        "type": "object",
+                        "properties": {action: {"type": "string"} for action in missing},
+                        "required": missing,
+                        "additionalProperties": False
+                    }
+                }},
+                max_tokens=500 * len(missing),
+                stream=True
+            )
+            # Fields come in schema order, so the first action streams first
+            output = stream_completion(
+                stream, lambda output: streamed_field(output, actions[0]) if streamed else "")
+            results = json.loads(output)
     except Exception as e:
-        return jsonify({"error": str(e)}), 500
+        return {"error": str(e)}, 500
+
+    cache_results(key, results)
+    return process_response(actions, dict(cached, **results), cached), 200
+
+
+@app.route("/job/<job_id>", methods=["GET"])
+def job_status(job_id):
+    """A job's status; once done (or failed) its result fields are merged in.
+    The poll itself always answers 200, the job's own code is in http_status.
+
+    While it runs, text is what streamed since ?cursor= (pass back the
+    returned cursor); ?wait=N holds the request up to N seconds (at most
+    MAX_JOB_WAIT_SECONDS) until there is new text or the job finishes.
+    """
+    try:
+        cursor = max(int(request.args.get("cursor", 0)), 0)
+        wait = min(max(float(request.args.get("wait", 0)), 0), MAX_JOB_WAIT_SECONDS)
+    except ValueError:
+        return jsonify({"error": "Invalid cursor or wait"}), 400
+
+    with jobs_changed:
+        job = jobs.get(job_id)
+        if not job:
+            return jsonify({"error": "Job not found"}), 404
+        if wait:
+            jobs_changed.wait_for(lambda: job["result"] is not None or len(job["partial"]) > cursor,
+                                  timeout=wait)
+        job = dict(job)
+
+    body = {"job_id": job_id, "kind": job["kind"], "status": job["status"]}
+    if job["result"] is not None:
+        body.update(job["result"])
+        body["http_status"] = job["http_status"]
+    else:
+        body["waited_seconds"] = round(time.time() - job["created"], 1)
+        body["text"] = job["partial"][cursor:]
+        body["cursor"] = max(len(job["partial"]), cursor)
+    return jsonify(body)
+
+
+def secret_digest(secret):
+    return hashlib.sha256(secret.encode()).hexdigest()
+
+
+def authorize_device(issue=False):
+    """Check a /notes request's X-Device-Id and X-Device-Secret
+
+    Returns (device, issued, error): issued is a secret handed out now (sent
+    back as device_secret), error a response to return instead. A device's
+    first sync (issue=True) is issued a secret that every later request must
+    send. Until the device has sent it once, a sync without it is given the
+    same secret again, so a lost response doesn't lock the device out.
+    Reads never issue one.
+    """
+    device = request.headers.get("X-Device-Id")
+    if not device:
+        return None, None, (jsonify({"error": "Missing X-Device-Id header"}), 400)
+    sent = request.headers.get("X-Device-Secret")
+
+    with notes_lock:
+        record = note_store.get_secret(device)
+        if record is None and issue:
+            secret = secrets.token_hex(16)
+            note_store.set_secret(device, {"sha256": secret_digest(secret), "pending": secret})
+            return device, secret, None
+        if record and sent and hmac.compare_digest(secret_digest(sent), record["sha256"]):
+            if record.get("pending"):
+                note_store.set_secret(device, {"sha256": record["sha256"]})  # Confirmed
+            return device, None, None
+        if record and not sent and issue and record.get("pending"):
+            return device, record["pending"], None
+
+    return None, None, (jsonify({"error": "Invalid or missing X-Device-Secret"}), 401)
+
+
+@app.route("/notes/<note_id>", methods=["POST"])
+def sync_note(note_id):
+    """Apply a note delta pushed by a device's background sync
+
+    Body is {"version", "base_version", "fields"}: the fields that changed
+    since base_version, the version the server last acknowledged (0 sends
+    the whole note, replacing what is stored). {"deleted": true} drops the
+    note. A delta the server has already applied is acked again; one built
+    on a version the server doesn't have gets 409, and the device sends the
+    whole note instead. A device's first sync gets its secret back as
+    device_secret (see authorize_device).
+    """
+    device, issued, error = authorize_device(issue=True)
+    if error:
+        return error
+
+    data = request.get_json(silent=True)
+    if not isinstance(data, dict):
+        return jsonify({"error": "Expected a JSON object"}), 400
+
+    if data.get("deleted"):
+        with notes_lock:
+            note_store.delete(device, note_id)
+        return jsonify(with_secret({"id": note_id, "deleted": True}, issued))
+
+    try:
+        version = int(data.get("version"))
+        base_version = int(data.get("base_version") or 0)
+    except (TypeError, ValueError):
+        return jsonify({"error": "Invalid version"}), 400
+    fields = data.get("fields")
+    if not isinstance(fields, dict):
+        return jsonify({"error": "Missing fields"}), 400
+
+    with notes_lock:
+        stored = note_store.get(device, note_id)
+        stored_version = stored["version"] if stored else 0
+        if base_version and stored_version >= version:
+            # A retry whose ack was lost
+            return jsonify(with_secret({"id": note_id, "version": stored_version, "duplicate": True}, issued))
+        if base_version and stored_version < base_version:
+            return jsonify(with_secret({"error": "Base version not stored", "version": stored_version}, issued)), 409
+
+        note = stored if base_version else {"id": note_id}
+        for name in NOTE_FIELDS:
+            if name in fields:
+                note[name] = fields[name]
+        note["version"] = version
+        note["updated"] = time.time()
+        note_store.put(device, note_id, note)
+
+    return jsonify(with_secret({"id": note_id, "version": version, "duplicate": False}, issued))
+
+
+def with_secret(body, issued):
+    if issued:
+        body["device_secret"] = issued
+    return body
+
+
+@app.route("/notes", methods=["GET"])
+def list_notes():
+    """A device's backed-up notes, without their text (GET /notes/<id> for that)"""
+    device, _, error = authorize_device()
+    if error:
+        return error
+
+    with notes_lock:
+        notes = note_store.list(device)
+    summaries = [{key: note.get(key) for key in ("id", "version", "created_at", "duration_seconds")}
+                 for note in notes]
+    summaries.sort(key=lambda n: n["created_at"] or "", reverse=True)
+    return jsonify({"notes": summaries})
+
+
+@app.route("/notes/<note_id>", methods=["GET"])
+def get_note(note_id):
+    """One backed-up note, every field (for restoring it to a device)"""
+    device, _, error = authorize_device()
+    if error:
+        return error
+
+    with notes_lock:
+        note = note_store.get(device, note_id)
+    if not note:
+        return jsonify({"error": "Note not found"}), 404
+    return jsonify(note)
 
 
 @app.route("/email", methods=["POST"])
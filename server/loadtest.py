@@ -0,0 +1,342 @@
+"""
+Load generator for the CrankScribe server
+
+Replays recorded sessions as N simulated devices uploading at once: each
+device sends a session's chunks paced like a recording (a chunk every chunk
+length, divided by --speed), finalizes, and long-polls the job until the
+transcript arrives. Run the server with OPENAI_STUB=1 to load it without
+calling OpenAI (see stub_openai.py).
+
+Sessions come from (in order of preference):
+- directories saved by SESSION_STORE=disk (<seq>.bin + <seq>.json per chunk),
+  replayed with their original headers
+- .wav (16-bit mono) or .ul (raw 8kHz μ-law) files, cut into --chunk-seconds
+  μ-law chunks at 8kHz
+- synthetic --seconds long tone bursts, when no paths are given
+
+Reports p50/p90/p99/max latency per endpoint, finalize-to-transcript time,
+429s and errors, and the server's RSS and queue depth sampled from /metrics.
+
+    python loadtest.py --server http://localhost:5000 --devices 20 --speed 10
+    python loadtest.py --devices 8 sessions/*
+"""
+
+import argparse
+import audioop
+import json
+import math
+import os
+import struct
+import threading
+import time
+import urllib.error
+import urllib.request
+import uuid
+import wave
+
+INPUT_SAMPLE_RATE = 8000
+FRAME_MS = 20
+
+
+class Stats:
+    """Latencies and outcomes from every device thread"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = {}   # endpoint -> [seconds]
+        self.statuses = {}    # (endpoint, status) -> count
+        self.finalize = []    # (recording seconds, finalize POST -> transcript seconds)
+        self.failures = []    # Sessions that ended without a transcript
+        self.audio_bytes = 0
+
+    def record(self, endpoint, seconds, status):
+        with self.lock:
+            self.latencies.setdefault(endpoint, []).append(seconds)
+            self.statuses[(endpoint, status)] = self.statuses.get((endpoint, status), 0) + 1
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of a non-empty list"""
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, max(0, math.ceil(p / 100 * len(ordered)) - 1))]
+
+
+def request(stats, server, endpoint, method="GET", path=None, body=None, headers=None, timeout=60):
+    """One HTTP request; returns (status, headers, parsed JSON or None)"""
+    req = urllib.request.Request(server + (path or endpoint), data=body, method=method,
+                                 headers=headers or {})
+    started = time.monotonic()
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as response:
+            status, response_headers, data = response.status, response.headers, response.read()
+    except urllib.error.HTTPError as e:
+        status, response_headers, data = e.code, e.headers, e.read()
+    except (urllib.error.URLError, OSError):
+        status, response_headers, data = 0, {}, b""  # Connection failed or timed out
+    stats.record(endpoint, time.monotonic() - started, status)
+    try:
+        return status, response_headers, json.loads(data) if data else None
+    except ValueError:
+        return status, response_headers, None
+
+
+# ============================================================================
+# Sessions: lists of {"data", "headers", "seconds"} chunks
+# ============================================================================
+
+def frame_map_bytes(runs):
+    return struct.pack(f"<{len(runs)}H", *runs)
+
+
+def load_store_session(path):
+    """A session directory written by DiskSessionStore"""
+    seqs = sorted(int(n[:-5]) for n in os.listdir(path) if n.endswith(".json") and n[:-5].lstrip("-").isdigit())
+    chunks = []
+    for seq in seqs:
+        with open(os.path.join(path, f"{seq}.bin"), "rb") as f:
+            audio = f.read()
+        with open(os.path.join(path, f"{seq}.json")) as f:
+            info = json.load(f)
+        frame_map = frame_map_bytes(info["frame_map"]) if info.get("frame_map") else b""
+        rate = info.get("sample_rate", INPUT_SAMPLE_RATE)
+        if info.get("frame_map"):
+            seconds = sum(info["frame_map"]) * FRAME_MS / 1000
+        elif info.get("content_type") == "audio/x-ima-adpcm":
+            seconds = max(len(audio) - 4, 0) * 2 / rate
+        else:
+            seconds = len(audio) / rate
+        chunks.append({"data": frame_map + audio, "seconds": seconds, "headers": {
+            "Content-Type": info.get("content_type", "audio/mulaw"),
+            "X-Chunk-Seq": str(seq),
+            "X-Sample-Rate": str(rate),
+            "X-Frame-Map-Bytes": str(len(frame_map)),
+            "X-Overlap-Frames": str(info.get("overlap_frames", 0)),
+        }})
+    return chunks
+
+
+def mulaw_session(mulaw, chunk_seconds):
+    """Cut 8kHz μ-law audio into chunks the way the device does (no VAD)"""
+    size = int(chunk_seconds * INPUT_SAMPLE_RATE)
+    return [{"data": mulaw[i:i + size], "seconds": len(mulaw[i:i + size]) / INPUT_SAMPLE_RATE, "headers": {
+        "Content-Type": "audio/mulaw",
+        "X-Chunk-Seq": str(i // size),
+        "X-Sample-Rate": str(INPUT_SAMPLE_RATE),
+    }} for i in range(0, len(mulaw), size)]
+
+
+def load_wav(path):
+    with wave.open(path, "rb") as w:
+        if w.getsampwidth() != 2:
+            raise ValueError(f"{path}: need 16-bit PCM")
+        pcm = w.readframes(w.getnframes())
+        if w.getnchannels() == 2:
+            pcm = audioop.tomono(pcm, 2, 0.5, 0.5)
+        elif w.getnchannels() != 1:
+            raise ValueError(f"{path}: need mono or stereo")
+        pcm, _ = audioop.ratecv(pcm, 2, 1, w.getframerate(), INPUT_SAMPLE_RATE, None)
+    return audioop.lin2ulaw(pcm, 2)
+
+
+def synthetic_mulaw(seconds):
+    """Tone bursts: 1.5s of 'speech' then 0.5s of quiet, repeated"""
+    samples = []
+    for n in range(int(seconds * INPUT_SAMPLE_RATE)):
+        t = n / INPUT_SAMPLE_RATE
+        loud = (t % 2) < 1.5
+        samples.append(int((8000 if loud else 40) * math.sin(2 * math.pi * (180 + 60 * math.sin(t)) * t)))
+    return audioop.lin2ulaw(struct.pack(f"<{len(samples)}h", *samples), 2)
+
+
+def load_sessions(paths, seconds, chunk_seconds):
+    if not paths:
+        return [("synthetic", mulaw_session(synthetic_mulaw(seconds), chunk_seconds))]
+    sessions = []
+    for path in paths:
+        if os.path.isdir(path):
+            sessions.append((path, load_store_session(path)))
+        elif path.endswith(".wav"):
+            sessions.append((path, mulaw_session(load_wav(path), chunk_seconds)))
+        else:
+            with open(path, "rb") as f:
+                sessions.append((path, mulaw_session(f.read(), chunk_seconds)))
+    return [(name, chunks) for name, chunks in sessions if chunks]
+
+
+# ============================================================================
+# Simulated device
+# ============================================================================
+
+def post_with_backoff(stats, server, endpoint, body, headers, deadline):
+    """POST, waiting out 429s (Retry-After) like the device does"""
+    while True:
+        status, response_headers, data = request(stats, server, endpoint, "POST", body=body, headers=headers)
+        if status != 429 or time.monotonic() > deadline:
+            return status, data
+        time.sleep(float(response_headers.get("Retry-After") or 1))
+
+
+def run_session(stats, args, name, chunks):
+    session_id = str(uuid.uuid4())
+    deadline = time.monotonic() + args.timeout
+    started = time.monotonic()
+    recorded = 0
+    for chunk in chunks:
+        # A chunk is uploaded once it has been recorded
+        recorded += chunk["seconds"]
+        delay = started + recorded / args.speed - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+        status, _ = post_with_backoff(stats, args.server, "/chunk", chunk["data"],
+                                      dict(chunk["headers"], **{"X-Session-Id": session_id}), deadline)
+        with stats.lock:
+            stats.audio_bytes += len(chunk["data"])
+        if status != 200:
+            stats.failures.append((name, f"chunk {chunk['headers']['X-Chunk-Seq']}: HTTP {status}"))
+            return
+
+    finalize_started = time.monotonic()
+    status, data = post_with_backoff(stats, args.server, "/finalize", b"", {"X-Session-Id": session_id}, deadline)
+    if status != 202 or not data:
+        stats.failures.append((name, f"finalize: HTTP {status}"))
+        return
+    job_id = data["job_id"]
+    while time.monotonic() < deadline:
+        status, _, data = request(stats, args.server, "/job/<job_id>", path=f"/job/{job_id}?wait=5")
+        if status == 200 and data and data.get("http_status"):
+            if data["http_status"] != 200:
+                stats.failures.append((name, f"job: {data.get('error')}"))
+                return
+            with stats.lock:
+                stats.finalize.append((recorded, time.monotonic() - finalize_started))
+            return
+        if status != 200:
+            time.sleep(1)
+    stats.failures.append((name, "timed out"))
+
+
+def run_device(stats, args, queue):
+    while True:
+        with stats.lock:
+            if not queue:
+                return
+            name, chunks = queue.pop()
+        run_session(stats, args, name, chunks)
+
+
+# ============================================================================
+# Server metrics sampling
+# ============================================================================
+
+def scrape(server):
+    """The /metrics samples as {name{labels}: value}"""
+    try:
+        with urllib.request.urlopen(server + "/metrics", timeout=5) as response:
+            text = response.read().decode()
+    except (urllib.error.URLError, OSError):
+        return None
+    samples = {}
+    for line in text.splitlines():
+        if line and not line.startswith("#"):
+            key, _, value = line.rpartition(" ")
+            samples[key] = float(value)
+    return samples
+
+
+def sample_server(args, samples, done):
+    while not done.wait(args.sample_interval):
+        sample = scrape(args.server)
+        if sample:
+            samples.append(sample)
+
+
+def gauge_sum(sample, name):
+    return sum(v for k, v in sample.items() if k == name or k.startswith(name + "{"))
+
+
+# ============================================================================
+# Report
+# ============================================================================
+
+def report(stats, samples, elapsed, before, after):
+    print(f"\n{'endpoint':<16}{'requests':>9}{'p50 ms':>9}{'p90 ms':>9}{'p99 ms':>9}{'max ms':>9}")
+    for endpoint, values in sorted(stats.latencies.items()):
+        row = [percentile(values, p) * 1000 for p in (50, 90, 99, 100)]
+        print(f"{endpoint:<16}{len(values):>9}" + "".join(f"{v:>9.0f}" for v in row))
+
+    print("\nstatus codes: " + ", ".join(f"{endpoint} {status or 'conn'}: {count}"
+                                         for (endpoint, status), count in sorted(stats.statuses.items())))
+    if stats.finalize:
+        waits = [seconds for _, seconds in stats.finalize]
+        print(f"finalize -> transcript: {len(waits)} sessions, p50 {percentile(waits, 50):.2f}s, "
+              f"p99 {percentile(waits, 99):.2f}s, max {max(waits):.2f}s")
+    print(f"uploaded {stats.audio_bytes / 1024:.0f} KB in {elapsed:.1f}s "
+          f"({stats.audio_bytes / 1024 / elapsed:.1f} KB/s)")
+    for name, reason in stats.failures[:10]:
+        print(f"failed: {name}: {reason}")
+    if len(stats.failures) > 10:
+        print(f"... {len(stats.failures) - 10} more failures")
+
+    if samples and before:
+        rss = [s.get("process_resident_memory_bytes", 0) for s in samples]
+        print(f"\nserver RSS: {before.get('process_resident_memory_bytes', 0) / 2**20:.1f} MB before, "
+              f"{max(rss) / 2**20:.1f} MB peak, "
+              f"{(after or samples[-1]).get('process_resident_memory_bytes', 0) / 2**20:.1f} MB after")
+        print(f"peak jobs waiting/running: {max(gauge_sum(s, 'crankscribe_jobs') for s in samples):.0f}, "
+              f"background transcriptions: "
+              f"{max(s.get('crankscribe_transcriptions_in_flight', 0) for s in samples):.0f}, "
+              f"sessions: {max(s.get('crankscribe_active_sessions', 0) for s in samples):.0f}")
+    else:
+        print("\n(no /metrics from the server; RSS and queue depth not sampled)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("paths", nargs="*", help="session directories, .wav or .ul files")
+    parser.add_argument("--server", default="http://localhost:5000")
+    parser.add_argument("--devices", type=int, default=10, help="simulated devices uploading at once")
+    parser.add_argument("--sessions", type=int, default=0,
+                        help="sessions to run (default: one per device, cycling through the inputs)")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay faster than real time")
+    parser.add_argument("--seconds", type=float, default=120, help="length of the synthetic session")
+    parser.add_argument("--chunk-seconds", type=float, default=30, help="chunk length for .wav/.ul inputs")
+    parser.add_argument("--timeout", type=float, default=600, help="give up on a session after this long")
+    parser.add_argument("--sample-interval", type=float, default=1.0, help="seconds between /metrics scrapes")
+    args = parser.parse_args()
+    args.server = args.server.rstrip("/")
+
+    sessions = load_sessions(args.paths, args.seconds, args.chunk_seconds)
+    if not sessions:
+        parser.error("no chunks in the given sessions")
+    count = args.sessions or args.devices
+    queue = [sessions[i % len(sessions)] for i in range(count)][::-1]
+    recorded = sum(sum(c["seconds"] for c in chunks) for _, chunks in queue)
+    print(f"{count} sessions ({recorded / 60:.1f} min of recording) over {args.devices} devices "
+          f"at {args.speed:g}x against {args.server}")
+
+    stats = Stats()
+    samples = []
+    done = threading.Event()
+    before = scrape(args.server)
+    sampler = threading.Thread(target=sample_server, args=(args, samples, done), daemon=True)
+    sampler.start()
+
+    started = time.monotonic()
+    devices = [threading.Thread(target=run_device, args=(stats, args, queue), daemon=True)
+               for _ in range(args.devices)]
+    for device in devices:
+        device.start()
+    for device in devices:
+        device.join()
+    elapsed = time.monotonic() - started
+    done.set()
+    after = scrape(args.server)
+    if after:
+        samples.append(after)
+
+    report(stats, samples, elapsed, before, after)
+    return 1 if stats.failures else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
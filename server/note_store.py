@@ -0,0 +1,172 @@
+"""
+Note backup storage for the CrankScribe server
+
+Devices push their notes here in the background (POST /notes/<id>) as
+versioned deltas. A note is kept as one JSON dict - the note's fields plus
+its "version" and "updated" time - under the device's id, so two devices'
+notes never collide even though note ids are timestamps. Notes do not expire.
+Each device also has a secret record ({"sha256", "pending"}, see app.py),
+issued on its first sync and required to read its notes back.
+
+Backends (pick with NOTE_STORE):
+- memory: in-process dict (lost on restart; for local testing)
+- disk:   <device>/<note>.json under NOTE_DIR (default; survives restarts)
+- redis:  one hash per device at "crankscribe:notes:<device>" on REDIS_URL
+"""
+
+import os
+import json
+
+
+def _safe(name):
+    # Ids come from devices; keep them to a safe file name / key part
+    return "".join(c for c in name if c.isalnum() or c in "-_")[:64] or "_"
+
+
+class NoteStore:
+    """Interface every backend implements"""
+
+    def get(self, device_id, note_id):
+        """The stored note dict, or None"""
+        raise NotImplementedError
+
+    def put(self, device_id, note_id, note):
+        raise NotImplementedError
+
+    def delete(self, device_id, note_id):
+        raise NotImplementedError
+
+    def list(self, device_id):
+        """Every note of a device (full dicts)"""
+        raise NotImplementedError
+
+    def get_secret(self, device_id):
+        """The device's secret record, or None before its first sync"""
+        raise NotImplementedError
+
+    def set_secret(self, device_id, record):
+        raise NotImplementedError
+
+
+class MemoryNoteStore(NoteStore):
+    def __init__(self):
+        self.devices = {}
+        self.secrets = {}
+
+    def get(self, device_id, note_id):
+        note = self.devices.get(device_id, {}).get(note_id)
+        return dict(note) if note else None
+
+    def put(self, device_id, note_id, note):
+        self.devices.setdefault(device_id, {})[note_id] = dict(note)
+
+    def delete(self, device_id, note_id):
+        self.devices.get(device_id, {}).pop(note_id, None)
+
+    def list(self, device_id):
+        return [dict(note) for note in self.devices.get(device_id, {}).values()]
+
+    def get_secret(self, device_id):
+        record = self.secrets.get(device_id)
+        return dict(record) if record else None
+
+    def set_secret(self, device_id, record):
+        self.secrets[device_id] = dict(record)
+
+
+class DiskNoteStore(NoteStore):
+    """One directory per device, one <note>.json per note and its device_secret
+    (files replaced atomically)"""
+
+    def __init__(self, root):
+        self.root = root
+        os.makedirs(root, exist_ok=True)
+
+    def _path(self, device_id, note_id):
+        return os.path.join(self.root, _safe(device_id), _safe(note_id) + ".json")
+
+    def get(self, device_id, note_id):
+        return self._read(self._path(device_id, note_id))
+
+    def _read(self, path):
+        try:
+            with open(path, "rb") as f:
+                return json.loads(f.read())
+        except FileNotFoundError:
+            return None
+
+    def _write(self, path, data):
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        tmp = path + ".tmp"
+        with open(tmp, "wb") as f:
+            f.write(json.dumps(data).encode())
+        os.replace(tmp, path)
+
+    def put(self, device_id, note_id, note):
+        self._write(self._path(device_id, note_id), note)
+
+    def delete(self, device_id, note_id):
+        try:
+            os.remove(self._path(device_id, note_id))
+        except FileNotFoundError:
+            pass
+
+    def list(self, device_id):
+        directory = os.path.join(self.root, _safe(device_id))
+        if not os.path.isdir(directory):
+            return []
+        notes = []
+        for name in sorted(os.listdir(directory)):
+            if name.endswith(".json"):
+                note = self.get(device_id, name[:-5])
+                if note:
+                    notes.append(note)
+        return notes
+
+    def _secret_path(self, device_id):
+        return os.path.join(self.root, _safe(device_id), "device_secret")  # No .json: not a note
+
+    def get_secret(self, device_id):
+        return self._read(self._secret_path(device_id))
+
+    def set_secret(self, device_id, record):
+        self._write(self._secret_path(device_id), record)
+
+
+class RedisNoteStore(NoteStore):
+    def __init__(self, url):
+        import redis  # Optional dependency, only needed for this backend
+        self.redis = redis.Redis.from_url(url)
+
+    def _key(self, device_id):
+        return f"crankscribe:notes:{_safe(device_id)}"
+
+    def get(self, device_id, note_id):
+        note = self.redis.hget(self._key(device_id), note_id)
+        return json.loads(note) if note else None
+
+    def put(self, device_id, note_id, note):
+        self.redis.hset(self._key(device_id), note_id, json.dumps(note))
+
+    def delete(self, device_id, note_id):
+        self.redis.hdel(self._key(device_id), note_id)
+
+    def list(self, device_id):
+        return [json.loads(v) for v in self.redis.hvals(self._key(device_id))]
+
+    def get_secret(self, device_id):
+        record = self.redis.get(self._key(device_id) + ":secret")
+        return json.loads(record) if record else None
+
+    def set_secret(self, device_id, record):
+        self.redis.set(self._key(device_id) + ":secret", json.dumps(record))
+
+
+def make_note_store():
+    """Build the backend selected by NOTE_STORE (disk, memory or redis)"""
+    kind = os.environ.get("NOTE_STORE", "disk")
+    if kind == "memory":
+        return MemoryNoteStore()
+    if kind == "redis":
+        return RedisNoteStore(os.environ.get("REDIS_URL", "redis://localhost:6379/0"))
+    return DiskNoteStore(os.environ.get("NOTE_DIR", "notes"))
@@ -0,0 +1,309 @@
+"""
+Session storage for the CrankScribe server
+
+A session holds a recording's chunks (audio bytes plus JSON-able info such as
+the frame map), the per-chunk transcripts, and a small meta dict. Sessions
+expire after a period of inactivity (sliding: every write or touch renews it).
+
+Backends (pick with SESSION_STORE):
+- memory: in-process dict (default; lost on restart)
+- disk:   one directory per session under SESSION_DIR (survives restarts)
+- redis:  keys under "crankscribe:<session>:" at REDIS_URL (shared, TTL-expired)
+
+Chunk writes are idempotent: a re-sent sequence number is acknowledged
+without replacing what is already stored.
+"""
+
+import os
+import json
+import shutil
+import time
+
+
+class SessionStore:
+    """Interface every backend implements"""
+
+    def __init__(self, idle_seconds):
+        self.idle_seconds = idle_seconds
+
+    def touch(self, session_id):
+        """Create the session if needed and renew its expiry"""
+        raise NotImplementedError
+
+    def exists(self, session_id):
+        raise NotImplementedError
+
+    def add_chunk(self, session_id, seq, data, info):
+        """Store a chunk; returns False (and keeps the original) if seq exists"""
+        raise NotImplementedError
+
+    def chunk_seqs(self, session_id):
+        """Sorted sequence numbers of the stored chunks"""
+        raise NotImplementedError
+
+    def get_chunk(self, session_id, seq):
+        """Returns (data, info)"""
+        raise NotImplementedError
+
+    def set_transcript(self, session_id, seq, transcript):
+        raise NotImplementedError
+
+    def get_transcripts(self, session_id):
+        """Dict of seq -> transcript"""
+        raise NotImplementedError
+
+    def get_meta(self, session_id):
+        raise NotImplementedError
+
+    def update_meta(self, session_id, **fields):
+        raise NotImplementedError
+
+    def delete(self, session_id):
+        raise NotImplementedError
+
+    def expire(self):
+        """Drop sessions idle longer than idle_seconds; returns their ids"""
+        raise NotImplementedError
+
+    def count(self):
+        raise NotImplementedError
+
+    def new_meta(self):
+        now = time.time()
+        return {"created": now, "last_activity": now}
+
+
+class MemorySessionStore(SessionStore):
+    """In-process dict (state is lost when the server restarts)"""
+
+    def __init__(self, idle_seconds):
+        super().__init__(idle_seconds)
+        self.sessions = {}
+
+    def touch(self, session_id):
+        session = self.sessions.get(session_id)
+        if not session:
+            session = self.sessions[session_id] = {"chunks": {}, "transcripts": {},
+                                                    "meta": self.new_meta()}
+        session["meta"]["last_activity"] = time.time()
+
+    def exists(self, session_id):
+        return session_id in self.sessions
+
+    def add_chunk(self, session_id, seq, data, info):
+        self.touch(session_id)
+        chunks = self.sessions[session_id]["chunks"]
+        if seq in chunks:
+            return False
+        chunks[seq] = (data, info)
+        return True
+
+    def chunk_seqs(self, session_id):
+        return sorted(self.sessions[session_id]["chunks"])
+
+    def get_chunk(self, session_id, seq):
+        return self.sessions[session_id]["chunks"][seq]
+
+    def set_transcript(self, session_id, seq, transcript):
+        self.sessions[session_id]["transcripts"][seq] = transcript
+
+    def get_transcripts(self, session_id):
+        return dict(self.sessions[session_id]["transcripts"])
+
+    def get_meta(self, session_id):
+        return dict(self.sessions[session_id]["meta"])
+
+    def update_meta(self, session_id, **fields):
+        self.sessions[session_id]["meta"].update(fields)
+
+    def delete(self, session_id):
+        self.sessions.pop(session_id, None)
+
+    def expire(self):
+        cutoff = time.time() - self.idle_seconds
+        expired = [sid for sid, s in self.sessions.items() if s["meta"]["last_activity"] < cutoff]
+        for sid in expired:
+            del self.sessions[sid]
+        return expired
+
+    def count(self):
+        return len(self.sessions)
+
+
+class DiskSessionStore(SessionStore):
+    """One directory per session: meta.json, transcripts.json, and a
+    <seq>.bin/<seq>.json pair per chunk (files replaced atomically)"""
+
+    def __init__(self, idle_seconds, root):
+        super().__init__(idle_seconds)
+        self.root = root
+        os.makedirs(root, exist_ok=True)
+
+    def _dir(self, session_id):
+        # Session ids come from devices; keep them to a safe file name
+        safe = "".join(c for c in session_id if c.isalnum() or c == "-")[:64]
+        return os.path.join(self.root, safe or "_")
+
+    def _write(self, path, data):
+        tmp = path + ".tmp"
+        with open(tmp, "wb") as f:
+            f.write(data)
+        os.replace(tmp, path)
+
+    def _read_json(self, path, default):
+        try:
+            with open(path, "rb") as f:
+                return json.loads(f.read())
+        except FileNotFoundError:
+            return default
+
+    def touch(self, session_id):
+        path = os.path.join(self._dir(session_id), "meta.json")
+        meta = self._read_json(path, None)
+        if meta is None:
+            os.makedirs(self._dir(session_id), exist_ok=True)
+            meta = self.new_meta()
+        meta["last_activity"] = time.time()
+        self._write(path, json.dumps(meta).encode())
+
+    def exists(self, session_id):
+        return os.path.exists(os.path.join(self._dir(session_id), "meta.json"))
+
+    def add_chunk(self, session_id, seq, data, info):
+        self.touch(session_id)
+        base = os.path.join(self._dir(session_id), str(seq))
+        if os.path.exists(base + ".json"):
+            return False
+        # Data first, info last: a chunk only counts once its info is there
+        self._write(base + ".bin", data)
+        self._write(base + ".json", json.dumps(info).encode())
+        return True
+
+    def chunk_seqs(self, session_id):
+        names = os.listdir(self._dir(session_id))
+        return sorted(int(n[:-5]) for n in names if n.endswith(".json") and n[:-5].lstrip("-").isdigit())
+
+    def get_chunk(self, session_id, seq):
+        base = os.path.join(self._dir(session_id), str(seq))
+        with open(base + ".bin", "rb") as f:
+            data = f.read()
+        return data, self._read_json(base + ".json", {})
+
+    def set_transcript(self, session_id, seq, transcript):
+        path = os.path.join(self._dir(session_id), "transcripts.json")
+        transcripts = self._read_json(path, {})
+        transcripts[str(seq)] = transcript
+        self._write(path, json.dumps(transcripts).encode())
+
+    def get_transcripts(self, session_id):
+        path = os.path.join(self._dir(session_id), "transcripts.json")
+        return {int(k): v for k, v in self._read_json(path, {}).items()}
+
+    def get_meta(self, session_id):
+        return self._read_json(os.path.join(self._dir(session_id), "meta.json"), self.new_meta())
+
+    def update_meta(self, session_id, **fields):
+        path = os.path.join(self._dir(session_id), "meta.json")
+        meta = self._read_json(path, self.new_meta())
+        meta.update(fields)
+        self._write(path, json.dumps(meta).encode())
+
+    def delete(self, session_id):
+        shutil.rmtree(self._dir(session_id), ignore_errors=True)
+
+    def expire(self):
+        cutoff = time.time() - self.idle_seconds
+        expired = []
+        for name in os.listdir(self.root):
+            meta = self._read_json(os.path.join(self.root, name, "meta.json"), None)
+            if meta is None or meta["last_activity"] < cutoff:
+                shutil.rmtree(os.path.join(self.root, name), ignore_errors=True)
+                expired.append(name)
+        return expired
+
+    def count(self):
+        return len(os.listdir(self.root))
+
+
+class RedisSessionStore(SessionStore):
+    """Redis keys per session, all given the idle TTL on every write"""
+
+    def __init__(self, idle_seconds, url):
+        super().__init__(idle_seconds)
+        import redis  # Optional dependency, only needed for this backend
+        self.redis = redis.Redis.from_url(url)
+
+    def _keys(self, session_id):
+        prefix = f"crankscribe:{session_id}:"
+        return {name: prefix + name for name in ("meta", "chunks", "info", "transcripts")}
+
+    def _renew(self, session_id):
+        pipe = self.redis.pipeline()
+        for key in self._keys(session_id).values():
+            pipe.expire(key, self.idle_seconds)
+        pipe.execute()
+
+    def touch(self, session_id):
+        key = self._keys(session_id)["meta"]
+        meta = self.redis.get(key)
+        meta = json.loads(meta) if meta else self.new_meta()
+        meta["last_activity"] = time.time()
+        self.redis.set(key, json.dumps(meta))
+        self._renew(session_id)
+
+    def exists(self, session_id):
+        return bool(self.redis.exists(self._keys(session_id)["meta"]))
+
+    def add_chunk(self, session_id, seq, data, info):
+        self.touch(session_id)
+        keys = self._keys(session_id)
+        # HSETNX on the data makes a re-sent chunk a no-op
+        if not self.redis.hsetnx(keys["chunks"], seq, data):
+            return False
+        self.redis.hset(keys["info"], seq, json.dumps(info))
+        self._renew(session_id)
+        return True
+
+    def chunk_seqs(self, session_id):
+        return sorted(int(k) for k in self.redis.hkeys(self._keys(session_id)["info"]))
+
+    def get_chunk(self, session_id, seq):
+        keys = self._keys(session_id)
+        return self.redis.hget(keys["chunks"], seq), json.loads(self.redis.hget(keys["info"], seq))
+
+    def set_transcript(self, session_id, seq, transcript):
+        self.redis.hset(self._keys(session_id)["transcripts"], seq, json.dumps(transcript))
+        self._renew(session_id)
+
+    def get_transcripts(self, session_id):
+        entries = self.redis.hgetall(self._keys(session_id)["transcripts"])
+        return {int(k): json.loads(v) for k, v in entries.items()}
+
+    def get_meta(self, session_id):
+        meta = self.redis.get(self._keys(session_id)["meta"])
+        return json.loads(meta) if meta else self.new_meta()
+
+    def update_meta(self, session_id, **fields):
+        meta = self.get_meta(session_id)
+        meta.update(fields)
+        self.redis.set(self._keys(session_id)["meta"], json.dumps(meta))
+        self._renew(session_id)
+
+    def delete(self, session_id):
+        self.redis.delete(*self._keys(session_id).values())
+
+    def expire(self):
+        return []  # Redis TTLs do this
+
+    def count(self):
+        return sum(1 for _ in self.redis.scan_iter("crankscribe:*:meta"))
+
+
+def make_session_store(idle_seconds):
+    """Build the backend selected by SESSION_STORE (memory, disk or redis)"""
+    kind = os.environ.get("SESSION_STORE", "memory")
+    if kind == "disk":
+        return DiskSessionStore(idle_seconds, os.environ.get("SESSION_DIR", "sessions"))
+    if kind == "redis":
+        return RedisSessionStore(idle_seconds, os.environ.get("REDIS_URL", "redis://localhost:6379/0"))
+    return MemorySessionStore(idle_seconds)
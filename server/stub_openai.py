@@ -0,0 +1,73 @@
+"""
+Offline stand-in for the OpenAI client, for load tests (OPENAI_STUB=1)
+
+Transcriptions sleep like Whisper would - a fixed round trip plus a share of
+the audio's length - and return placeholder words spread over the audio, so
+sessions go through the whole chunk -> background transcription -> finalize
+path without network access or API cost. Chat completions stream a short
+canned reply (JSON fields when a schema is given), so /process works too.
+
+- STUB_LATENCY_SECONDS (default 0.3): per-call round trip
+- STUB_SECONDS_PER_AUDIO_SECOND (default 0.02): added per second of audio
+"""
+
+import io
+import json
+import os
+import time
+
+try:
+    import soundfile
+except ImportError:
+    soundfile = None
+
+LATENCY_SECONDS = float(os.environ.get("STUB_LATENCY_SECONDS", 0.3))
+SECONDS_PER_AUDIO_SECOND = float(os.environ.get("STUB_SECONDS_PER_AUDIO_SECOND", 0.02))
+WORDS_PER_SECOND = 2.5
+
+
+class Obj:
+    def __init__(self, **fields):
+        self.__dict__.update(fields)
+
+
+def audio_seconds(audio_file):
+    """Length of the (filename, bytes) pair app.encode_audio produces"""
+    name, data = audio_file
+    if name.endswith(".flac") and soundfile:
+        return soundfile.info(io.BytesIO(data)).duration
+    return max(len(data) - 44, 0) / 32000  # 16kHz 16-bit mono WAV
+
+
+class Transcriptions:
+    def create(self, file, response_format="text", **kwargs):
+        seconds = audio_seconds(file)
+        time.sleep(LATENCY_SECONDS + SECONDS_PER_AUDIO_SECOND * seconds)
+        count = int(seconds * WORDS_PER_SECOND)
+        words = [Obj(word=f"word{i}", start=i / WORDS_PER_SECOND, end=(i + 0.8) / WORDS_PER_SECOND)
+                 for i in range(count)]
+        text = " ".join(w.word for w in words)
+        if response_format == "text":
+            return text
+        return Obj(text=text, words=words, duration=seconds)
+
+
+class Completions:
+    def create(self, messages, response_format=None, stream=False, **kwargs):
+        if response_format and response_format.get("type") == "json_schema":
+            fields = response_format["json_schema"]["schema"]["required"]
+            output = json.dumps({field: f"Stub {field}." for field in fields})
+        else:
+            output = "- Stub summary of the transcript."
+        time.sleep(LATENCY_SECONDS)
+        pieces = [output[i:i + 16] for i in range(0, len(output), 16)]
+        events = (Obj(choices=[Obj(delta=Obj(content=piece))]) for piece in pieces)
+        if stream:
+            return events
+        return Obj(choices=[Obj(message=Obj(content=output))])
+
+
+class StubClient:
+    def __init__(self):
+        self.audio = Obj(transcriptions=Transcriptions())
+        self.chat = Obj(completions=Completions())